@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+    BiquadCascade.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "BiquadCascade.h"
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::prepare(size_t maxSections, size_t numGroups) {
+    mMaxSections = maxSections;
+    mNumGroups = numGroups;
+    mNumSections = juce::jmin(mNumSections, mMaxSections);
+
+    mCoefficients.allocate(maxSections * coefficientsPerSection, true);
+    for (size_t section = 0; section < maxSections; section++)
+        mCoefficients[section * coefficientsPerSection] = static_cast<SampleType>(1.0);
+
+    // One extra register so that the states can start on a SIMD boundary
+    mStateData.allocate((2 * maxSections * numGroups + 1) * sizeof(Register), true);
+    mStates = reinterpret_cast<Register*>(Register::getNextSIMDAlignedPtr(reinterpret_cast<SampleType*>(mStateData.get())));
+    reset();
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::reset() {
+    for (size_t i = 0; i < 2 * mMaxSections * mNumGroups; i++)
+        mStates[i] = Register::expand(static_cast<SampleType>(0.0));
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::remapSections(const int* previousSections, size_t numSections) {
+    jassert(numSections <= mMaxSections);
+    const auto moveState = [this](size_t group, size_t from, size_t to) {
+        Register* source = getStates(group, from);
+        Register* destination = getStates(group, to);
+        destination[0] = source[0];
+        destination[1] = source[1];
+    };
+    for (size_t group = 0; group < mNumGroups; group++) {
+        /* The mapping is increasing, so sections moving down never overwrite a state still to be read
+           when done in ascending order, nor sections moving up in descending order */
+        for (size_t section = 0; section < numSections; section++)
+            if (previousSections[section] >= 0 && (size_t) previousSections[section] > section)
+                moveState(group, (size_t) previousSections[section], section);
+        for (size_t section = numSections; section-- > 0;)
+            if (previousSections[section] >= 0 && (size_t) previousSections[section] < section)
+                moveState(group, (size_t) previousSections[section], section);
+        for (size_t section = 0; section < numSections; section++)
+            if (previousSections[section] < 0)
+                getStates(group, section)[0] = getStates(group, section)[1] = Register::expand(static_cast<SampleType>(0.0));
+    }
+    mNumSections = numSections;
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::setSection(size_t section, const SampleType* coefficients) {
+    jassert(section < mMaxSections);
+    std::copy_n(coefficients, coefficientsPerSection, mCoefficients.get() + section * coefficientsPerSection);
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::process(Register* samples, size_t numSamples, size_t group) {
+    jassert(group < mNumGroups);
+    // One section over the whole block at a time : its coefficients and states stay in registers
+    for (size_t section = 0; section < mNumSections; section++) {
+        const SampleType* coefficients = mCoefficients.get() + section * coefficientsPerSection;
+        const Register b0 = Register::expand(coefficients[0]);
+        const Register b1 = Register::expand(coefficients[1]);
+        const Register b2 = Register::expand(coefficients[2]);
+        const Register a1 = Register::expand(coefficients[3]);
+        const Register a2 = Register::expand(coefficients[4]);
+        Register* states = getStates(group, section);
+        Register s1 = states[0], s2 = states[1];
+        for (size_t n = 0; n < numSamples; n++) {
+            const Register input = samples[n];
+            const Register output = b0 * input + s1;
+            s1 = b1 * input - a1 * output + s2;
+            s2 = b2 * input - a2 * output;
+            samples[n] = output;
+        }
+        states[0] = s1;
+        states[1] = s2;
+    }
+}
+
+template <typename SampleType>
+template <size_t Skew>
+void BiquadCascade<SampleType>::processSkewed(SampleType* samples, size_t numSamples, size_t group, size_t first) {
+    SampleType b0[Skew], b1[Skew], b2[Skew], a1[Skew], a2[Skew], s1[Skew], s2[Skew], outputs[Skew];
+    Register* states = getStates(group, first);
+    for (size_t j = 0; j < Skew; j++) {
+        const SampleType* coefficients = mCoefficients.get() + (first + j) * coefficientsPerSection;
+        b0[j] = coefficients[0];
+        b1[j] = coefficients[1];
+        b2[j] = coefficients[2];
+        a1[j] = coefficients[3];
+        a2[j] = coefficients[4];
+        s1[j] = states[2 * j].get(0);
+        s2[j] = states[2 * j + 1].get(0);
+        outputs[j] = static_cast<SampleType>(0.0);
+    }
+    const auto step = [&](size_t j, SampleType input) {
+        const SampleType output = b0[j] * input + s1[j];
+        s1[j] = b1[j] * input - a1[j] * output + s2[j];
+        s2[j] = b2[j] * input - a2[j] * output;
+        outputs[j] = output;
+    };
+
+    /* Step n feeds samples[n] to the first section and the output of section j - 1 at the previous step to
+       section j, which is then at sample n - j. Downwards so that each section reads the previous output
+       before it is replaced. Edge steps only run the sections holding a sample, the block leaves no sample
+       in flight. */
+    const auto edgeStep = [&](size_t n) {
+        const size_t lowest = n >= numSamples ? n - numSamples + 1 : 0;
+        const size_t highest = juce::jmin(n, Skew - 1);
+        for (size_t j = highest; j >= juce::jmax(lowest, (size_t) 1); j--)
+            step(j, outputs[j - 1]);
+        if (lowest == 0)
+            step(0, samples[n]);
+        if (n >= Skew - 1)
+            samples[n - (Skew - 1)] = outputs[Skew - 1];
+    };
+    const size_t fill = juce::jmin(Skew - 1, numSamples);
+    for (size_t n = 0; n < fill; n++)
+        edgeStep(n);
+    for (size_t n = Skew - 1; n < numSamples; n++) {
+        const SampleType input = samples[n];
+        for (size_t j = Skew - 1; j > 0; j--)
+            step(j, outputs[j - 1]);
+        step(0, input);
+        samples[n - (Skew - 1)] = outputs[Skew - 1];
+    }
+    for (size_t n = juce::jmax(numSamples, fill); n < numSamples + Skew - 1; n++)
+        edgeStep(n);
+
+    for (size_t j = 0; j < Skew; j++) {
+        states[2 * j].set(0, s1[j]);
+        states[2 * j + 1].set(0, s2[j]);
+    }
+}
+
+template <typename SampleType>
+void BiquadCascade<SampleType>::processMono(SampleType* samples, size_t numSamples, size_t group) {
+    jassert(group < mNumGroups);
+    size_t section = 0;
+    for (; section + skewSections <= mNumSections; section += skewSections)
+        processSkewed<skewSections>(samples, numSamples, group, section);
+    switch (mNumSections - section) {
+        case 3: processSkewed<3>(samples, numSamples, group, section); break;
+        case 2: processSkewed<2>(samples, numSamples, group, section); break;
+        case 1: processSkewed<1>(samples, numSamples, group, section); break;
+        default: break;
+    }
+}
+
+template class BiquadCascade<float>;
+template class BiquadCascade<double>;
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+    BiquadCascade.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Biquads in series, transposed direct form II, run on SIMDRegisters : one lane per channel, so a group
+   of SIMDNumElements channels (4 float channels with SSE / NEON) costs the same as one. Everything is
+   flat, no object per filter : the coefficients shared by all the lanes, b0 b1 b2 a1 a2 per section,
+   then the states of every group, [group][section][s1 s2], each state one aligned register.
+   A single channel (the linked side chain) would leave all the lanes but one idle, and one biquad is bound by
+   the latency of its own recursion, not by arithmetic. processMono() runs it on plain samples instead, with
+   up to skewSections sections in flight, each one sample behind the previous : their recursions are
+   independent, so the core overlaps them. Same output as the sections one after the other, measured about
+   twice as fast for four sections (float, x86-64, gcc -O2). */
+template <typename SampleType>
+class BiquadCascade {
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t laneCount = Register::SIMDNumElements;
+    static constexpr size_t coefficientsPerSection = 5;
+    static constexpr size_t skewSections = 4;
+
+    BiquadCascade() {};
+    ~BiquadCascade() {};
+
+    // Allocates, keep it off the audio thread. The sections start as identities
+    void prepare(size_t maxSections, size_t numGroups);
+    void reset();
+    size_t getNumSections() const { return mNumSections; }
+    size_t getMaxSections() const { return mMaxSections; }
+    /* New layout of numSections sections : section s takes the state of previousSections[s], -1 for a
+       section joining with a clean state. Kept sections must stay in the same order, the states then
+       move in place. Nothing is allocated. */
+    void remapSections(const int* previousSections, size_t numSections);
+    // b0 b1 b2 a1 a2, a0 normalised
+    void setSection(size_t section, const SampleType* coefficients);
+    // In place, the samples of one group of channels interleaved in registers
+    void process(Register* samples, size_t numSamples, size_t group);
+    // In place, one channel on the states of the first lane of the group, the one process() gives it
+    void processMono(SampleType* samples, size_t numSamples, size_t group);
+private:
+    // Sections first to first + Skew - 1, section j running j samples behind the first one
+    template <size_t Skew>
+    void processSkewed(SampleType* samples, size_t numSamples, size_t group, size_t first);
+    Register* getStates(size_t group, size_t section) {
+        return mStates + 2 * (group * mMaxSections + section);
+    }
+    juce::HeapBlock<SampleType> mCoefficients; // [section][coefficientsPerSection]
+    juce::HeapBlock<char> mStateData;
+    Register* mStates = nullptr; // aligned start in mStateData
+    size_t mMaxSections = 0, mNumSections = 0, mNumGroups = 0;
+};
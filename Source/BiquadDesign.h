@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+    BiquadDesign.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+// Highest Butterworth order designed, i.e. 48 dB/oct
+#define BIQUAD_DESIGN_MAX_ORDER 8
+
+/* Closed form biquad designs written straight into a caller owned [section][5] array of
+   normalised coefficients b0 b1 b2 a1 a2, the layout of BiquadCascade::setSection.
+   Nothing is allocated and a design is a handful of tan / sin / cos, so a parameter change only
+   redesigns the bands it moved, on the control thread. The results match juce::dsp::FilterDesign (high order
+   Butterworth method) and juce::dsp::IIR::Coefficients (RBJ peak / notch / shelves). */
+template <typename SampleType>
+struct BiquadDesign {
+    /* Quality factors of the second order sections of an even order Butterworth filter,
+       1 / (2 cos(pi (2k + 1) / (2 order))) for the pole pair k, lowest first */
+    static constexpr double butterworthQualities[BIQUAD_DESIGN_MAX_ORDER / 2][BIQUAD_DESIGN_MAX_ORDER / 2] = {
+        {0.70710678118654752, 0.0, 0.0, 0.0},
+        {0.54119610014619699, 1.30656296487637653, 0.0, 0.0},
+        {0.51763809020504152, 0.70710678118654752, 1.93185165257813657, 0.0},
+        {0.50979557910415917, 0.60134488693504528, 0.89997622313641570, 2.56291544774150617},
+    };
+
+    // Order 2, 4, 6 or 8. Returns the number of sections written, order / 2.
+    static size_t butterworthLowPass(SampleType (*sections)[5], double freq, double sampleRate, int order) noexcept {
+        return butterworth(sections, freq, sampleRate, order, false);
+    }
+
+    static size_t butterworthHighPass(SampleType (*sections)[5], double freq, double sampleRate, int order) noexcept {
+        return butterworth(sections, freq, sampleRate, order, true);
+    }
+
+    static void peak(SampleType* section, double freq, double sampleRate, double quality, double gainDb) noexcept {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double omega = twoPi * freq / sampleRate;
+        const double alpha = std::sin(omega) / (2.0 * quality);
+        const double c2 = -2.0 * std::cos(omega);
+        store(section, 1.0 + alpha * A, c2, 1.0 - alpha * A, 1.0 + alpha / A, c2, 1.0 - alpha / A);
+    }
+
+    static void notch(SampleType* section, double freq, double sampleRate, double quality) noexcept {
+        const double omega = twoPi * freq / sampleRate;
+        const double alpha = std::sin(omega) / (2.0 * quality);
+        const double c2 = -2.0 * std::cos(omega);
+        store(section, 1.0, c2, 1.0, 1.0 + alpha, c2, 1.0 - alpha);
+    }
+
+    static void lowShelf(SampleType* section, double freq, double sampleRate, double quality, double gainDb) noexcept {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double omega = twoPi * freq / sampleRate;
+        const double coso = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / quality;
+        const double aMinus1 = A - 1.0, aPlus1 = A + 1.0;
+        store(section,
+              A * (aPlus1 - aMinus1 * coso + beta),
+              A * 2.0 * (aMinus1 - aPlus1 * coso),
+              A * (aPlus1 - aMinus1 * coso - beta),
+              aPlus1 + aMinus1 * coso + beta,
+              -2.0 * (aMinus1 + aPlus1 * coso),
+              aPlus1 + aMinus1 * coso - beta);
+    }
+
+    static void highShelf(SampleType* section, double freq, double sampleRate, double quality, double gainDb) noexcept {
+        const double A = std::pow(10.0, gainDb / 40.0);
+        const double omega = twoPi * freq / sampleRate;
+        const double coso = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / quality;
+        const double aMinus1 = A - 1.0, aPlus1 = A + 1.0;
+        store(section,
+              A * (aPlus1 + aMinus1 * coso + beta),
+              A * -2.0 * (aMinus1 + aPlus1 * coso),
+              A * (aPlus1 + aMinus1 * coso - beta),
+              aPlus1 - aMinus1 * coso + beta,
+              2.0 * (aMinus1 - aPlus1 * coso),
+              aPlus1 - aMinus1 * coso - beta);
+    }
+
+private:
+    static constexpr double twoPi = 6.28318530717958648;
+
+    static size_t butterworth(SampleType (*sections)[5], double freq, double sampleRate, int order, bool highPass) noexcept {
+        const size_t numSections = (size_t) (order < 2 ? 1 : (order > BIQUAD_DESIGN_MAX_ORDER ? BIQUAD_DESIGN_MAX_ORDER : order) / 2);
+        // Bilinear transform with the cut off prewarped, one tan for every section
+        const double K = std::tan(0.5 * twoPi * freq / sampleRate);
+        const double K2 = K * K;
+        for (size_t section = 0; section < numSections; section++) {
+            const double quality = butterworthQualities[numSections - 1][section];
+            const double a0 = K2 + K / quality + 1.0;
+            const double a1 = 2.0 * (K2 - 1.0);
+            const double a2 = K2 - K / quality + 1.0;
+            if (highPass)
+                store(sections[section], 1.0, -2.0, 1.0, a0, a1, a2);
+            else
+                store(sections[section], K2, 2.0 * K2, K2, a0, a1, a2);
+        }
+        return numSections;
+    }
+
+    static void store(SampleType* section, double b0, double b1, double b2, double a0, double a1, double a2) noexcept {
+        const double a0Inv = 1.0 / a0;
+        section[0] = static_cast<SampleType>(b0 * a0Inv);
+        section[1] = static_cast<SampleType>(b1 * a0Inv);
+        section[2] = static_cast<SampleType>(b2 * a0Inv);
+        section[3] = static_cast<SampleType>(a1 * a0Inv);
+        section[4] = static_cast<SampleType>(a2 * a0Inv);
+    }
+};
@@ -1,168 +1,719 @@
-/*
-  ==============================================================================
-    Comp.cpp
-    Author:  Quentin Prost
-  ==============================================================================
-*/
-
-#include "Comp.h"
-
-template <typename SampleType>
-Comp<SampleType>::Comp() : mAhr(), mControlGainBuffer(), mSignalLevelBuffer(), mSideChainBuffer(), ballistic(), eq()
-{
-    mSampleRate = 44100;
-    mMaxBlockSize = 2048;
-}
-
-template <typename SampleType>
-Comp<SampleType>::Comp(int sampleRate, int maxBlockSize) :
-                                            mAhr(sampleRate, maxBlockSize),
-                                            mControlGainBuffer(1, maxBlockSize),
-                                            mSignalLevelBuffer(1, maxBlockSize),
-                                            mSideChainBuffer(1, maxBlockSize),
-                                            ballistic(),
-                                            eq(sampleRate)
-{
-    mSampleRate = sampleRate;
-    mMaxBlockSize = maxBlockSize;
-}
-
-template <typename SampleType>
-Comp<SampleType>::~Comp() {
-}
-
-template <typename SampleType>
-void Comp<SampleType>::prepare(const juce::dsp::ProcessSpec &spec) {
-    mSampleRate = spec.sampleRate;
-    mMaxBlockSize = spec.maximumBlockSize;
-    mNumChannels = spec.numChannels;
-    mAhr.prepare(spec);
-    mControlGainBuffer.setSize(1, mMaxBlockSize);
-    mSignalLevelBuffer.setSize(1, mMaxBlockSize);
-    mSideChainBuffer.setSize(1, mMaxBlockSize);
-    ballistic.setLevelCalculationType(mParams.estimationType);
-    ballistic.prepare(spec);
-    eq.prepare(spec);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setAttack(SampleType attack) {
-    mParams.attack = attack;
-    mAhr.setAttack(attack);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setHold(SampleType hold) {
-    mParams.hold = hold;
-    mAhr.setHold(hold);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setRelease(SampleType release) {
-    mParams.release = release;
-    mAhr.setRelease(release);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setThreshold(SampleType threshold) {
-    mParams.threshold = threshold;
-    mAhr.setThreshold(threshold);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setRatio(SampleType ratio) {
-    mParams.ratio = ratio;
-    mAhr.setRatio(ratio);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setKnee(SampleType knee) {
-    mParams.knee = knee;
-    mAhr.setKnee(knee);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setMakeUpGain(SampleType makeUpGain) {
-    mParams.makeUpGain = makeUpGain;
-    mAhr.setMakeUpGain(makeUpGain);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setExternalSideChain(bool value) {
-    mExternalSideChain = value;
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setEstimationType(EstimationType type) {
-    mParams.estimationType = type;
-    ballistic.setLevelCalculationType(type);
-    switch (type) {
-        case EstimationType::RMS:
-            ballistic.setAttackTime(300.0);
-            ballistic.setReleaseTime(300.0);
-            break;
-        case EstimationType::peak:
-            ballistic.setAttackTime(0.001);
-            ballistic.setReleaseTime(0.01);
-        default:
-            break;
-    }
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setEqSideChainBypass(bool bypass) {
-    mEqSideChainBypass = bypass;
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setEqBandBypass(size_t index, bool bypass) {
-    eq.setBandBypass(index, bypass);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::setEqBandParams(size_t index, FilterParams& params) {
-    eq.setBandParams(index, params);
-}
-
-template <typename SampleType>
-void Comp<SampleType>::processBlock(juce::dsp::ProcessContextNonReplacing<SampleType>& inputContext,
-                                    juce::dsp::ProcessContextNonReplacing<SampleType>& extSideChainContext) {
-        
-    
-    auto const& input = inputContext.getInputBlock();
-    auto& output = inputContext.getOutputBlock();
-    auto& sideChainInputContext = mExternalSideChain ? extSideChainContext : inputContext;
-    size_t blockSize = input.getNumSamples();
-    
-    juce::dsp::AudioBlock<SampleType> signalLevelBlock;
-    juce::dsp::AudioBlock<SampleType> outputGainsBlock(mControlGainBuffer);
-    juce::dsp::AudioBlock<SampleType> sideChainBlock;
-    
-    /*sideChainBlock.copyFrom(sideChainInput.getSingleChannelBlock(0));
-    sideChainBlock.add(sideChainInput.getSingleChannelBlock(1));
-    sideChainBlock.multiplyBy(0.5);*/
-    
-    if (!mEqSideChainBypass)
-        eq.processBlock(sideChainInputContext);
-    
-    /* Side Chain signal for ballistic filter is only mono at the moment (i.e fully linked stereo compression)
-     To do : Add a new parameters that can gradually unlinked the gain reduction for left & right channels */
-    sideChainBlock.copyFrom(sideChainInputContext.getOutputBlock().getSingleChannelBlock(0));
-    sideChainBlock.add(sideChainInputContext.getOutputBlock().getSingleChannelBlock(1));
-    sideChainBlock.multiplyBy(0.5);
-    
-    juce::dsp::ProcessContextNonReplacing<SampleType> context_ballistic(sideChainBlock, signalLevelBlock);
-    juce::dsp::ProcessContextNonReplacing<SampleType> context_ahr(signalLevelBlock, outputGainsBlock);
-    ballistic.process(context_ballistic);
-    mAhr.processBlock(context_ahr);
-    
-    for (int n = 0; n < blockSize; n++) {
-        for (int channel = 0; channel < mNumChannels; channel++) {
-            SampleType output_value = input.getSample(channel, n) * outputGainsBlock.getSample(0, n);
-            output.setSample(channel, n, output_value);
-        }
-    }
-}
-
-template class Comp<float>;
-template class Comp<double>;
+/*
+  ==============================================================================
+    Comp.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "Comp.h"
+
+template <typename SampleType>
+Comp<SampleType>::Comp() : mAhr(), mControlGainBuffer(), mSignalLevelBuffer(), mSideChainBuffer(), eq()
+{
+    mSampleRate = 44100;
+    mMaxBlockSize = 2048;
+    publishSettings();
+}
+
+template <typename SampleType>
+Comp<SampleType>::Comp(int sampleRate, int maxBlockSize) :
+                                            mAhr(sampleRate, maxBlockSize),
+                                            mControlGainBuffer(1, maxBlockSize),
+                                            mSignalLevelBuffer(1, maxBlockSize),
+                                            mSideChainBuffer(1, maxBlockSize),
+                                            eq(sampleRate)
+{
+    mSampleRate = sampleRate;
+    mMaxBlockSize = maxBlockSize;
+    publishSettings();
+}
+
+template <typename SampleType>
+Comp<SampleType>::~Comp() {
+}
+
+template <typename SampleType>
+void Comp<SampleType>::prepare(const juce::dsp::ProcessSpec &spec) {
+    mSampleRate = spec.sampleRate;
+    mMaxBlockSize = spec.maximumBlockSize;
+    mNumChannels = spec.numChannels;
+    prepareProcessing();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::prepareProcessing() {
+    mOversamplingFactor = mOversampling;
+    mOversampler.prepare(mOversamplingFactor, mMaxBlockSize, mNumChannels);
+    // The external side chain takes up to as many channels as the main bus
+    mSideChainOversampler.prepare(mOversamplingFactor, mMaxBlockSize, mNumChannels);
+    
+    // Sizes at the processing rate
+    const int blockSize = mMaxBlockSize * mOversamplingFactor;
+    mControlGainBuffer.setSize(1, blockSize);
+    mSignalLevelBuffer.setSize(1, blockSize);
+    mSideChainBuffer.setSize(1, blockSize);
+    mDecimatedBuffer.setSize(1, blockSize);
+    mDecimatedGainBuffer.setSize(1, blockSize);
+    // Mid / side takes two lanes even on a mono bus
+    const int numLanes = juce::jmax(2, mNumChannels);
+    mChannelSideChainBuffer.setSize(numLanes, blockSize);
+    mChannelGainBuffer.setSize(numLanes, blockSize);
+    mSideChainPointers.resize((size_t) numLanes);
+    mChannelBank.prepare((double) mSampleRate * mOversamplingFactor, blockSize, numLanes);
+    mDelayLine.prepare(mSampleRate * mOversamplingFactor,
+                       (int) ceil(COMP_MAX_LOOKAHEAD * mSampleRate) * mOversamplingFactor + COMP_MAX_EQ_LATENCY + COMP_MAX_DECIMATION_LATENCY + mOversamplingFactor,
+                       blockSize, mNumChannels);
+    for (auto& band : mDynamicBands)
+        band.prepare((double) mSampleRate * mOversamplingFactor, mNumChannels);
+    mDynamicBandActive.fill(false);
+    prepareDetector();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setOversampling(CompOversampling oversampling) {
+    if (oversampling == mOversampling)
+        return;
+    mOversampling = oversampling;
+    prepareProcessing();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::prepareDetector() {
+    // Only the linked detector runs decimated
+    const bool decimate = mOversamplingFactor == 1 && mLinkMode == COMP_LINK_LINKED;
+    mDecimationFactor = decimate ? (int) mDecimation : 1;
+    if (mDecimation == COMP_DECIMATION_AUTO && decimate) {
+        // Largest factor keeping the detector at 44.1 kHz or more
+        mDecimationFactor = 1;
+        while (mDecimationFactor < COMP_DECIMATION_8 && mSampleRate / (2 * mDecimationFactor) >= 44100)
+            mDecimationFactor *= 2;
+    }
+    
+    juce::dsp::ProcessSpec detectorSpec;
+    detectorSpec.sampleRate = getDetectorRate();
+    detectorSpec.maximumBlockSize = (juce::uint32) (mMaxBlockSize * mOversamplingFactor);
+    detectorSpec.numChannels = (juce::uint32) mNumChannels;
+    const double detectorRate = detectorSpec.sampleRate;
+    
+    mAhr.prepare(detectorSpec);
+    ballistic.state = static_cast<SampleType>(0.0);
+    // Linked, the EQ filters the downmix. Otherwise one EQ channel per detector lane
+    juce::dsp::ProcessSpec eqSpec = detectorSpec;
+    eqSpec.numChannels = (juce::uint32) juce::jmax(2, mNumChannels);
+    eq.prepare(eqSpec);
+    mDecimator.prepare(mDecimationFactor, mMaxBlockSize * mOversamplingFactor, 1);
+    mPreviousGain = mCurrentGain = static_cast<SampleType>(1.0);
+    mGainRamp = 0;
+    mPeakHold.prepare((int) ceil((COMP_MAX_LOOKAHEAD + COMP_MAX_HOLD) * detectorRate));
+    mRms.prepare((int) ceil(COMP_MAX_RMS_WINDOW * detectorRate), 1);
+    // Every time constant and window depends on the detector rate
+    publishSettings();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setDecimation(CompDecimation decimation) {
+    if (decimation == mDecimation)
+        return;
+    mDecimation = decimation;
+    prepareDetector();
+}
+
+template <typename SampleType>
+double Comp<SampleType>::getDetectorRate() const {
+    return (double) mSampleRate * mOversamplingFactor / mDecimationFactor;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setLinkMode(CompLinkMode mode) {
+    if (mode == mLinkMode)
+        return;
+    const bool wasLinked = mLinkMode == COMP_LINK_LINKED;
+    mLinkMode = mode;
+    // The lanes did not run while linked, the dynamic bands switch between left / right and mid / side
+    mChannelBank.reset();
+    for (auto& band : mDynamicBands)
+        band.reset();
+    // Decimation only applies to the linked detector
+    if (wasLinked != (mode == COMP_LINK_LINKED) && mDecimation != COMP_DECIMATION_OFF)
+        prepareDetector();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setLinkAmount(SampleType amount) {
+    mLinkAmount = juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(1.0), amount);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setAttack(SampleType attack) {
+    mParams.attack = attack;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setHold(SampleType hold) {
+    mParams.hold = hold;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setRelease(SampleType release) {
+    mParams.release = release;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setThreshold(SampleType threshold) {
+    mParams.threshold = threshold;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setRatio(SampleType ratio) {
+    mParams.ratio = ratio;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setKnee(SampleType knee) {
+    mParams.knee = knee;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setMakeUpGain(SampleType makeUpGain) {
+    mParams.makeUpGain = makeUpGain;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setExternalSideChain(bool value) {
+    mExternalSideChain = value;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setEstimationType(EstimationType type) {
+    mParams.estimationType = type;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setSpecialisedKernels(bool useSpecialisedKernels) {
+    mUseSpecialisedKernels = useSpecialisedKernels;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setGainTableSize(CompGainTableSize size) {
+    mGainTableSize = size;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setLookahead(SampleType lookahead) {
+    mLookahead = juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(COMP_MAX_LOOKAHEAD), lookahead);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setRmsWindow(SampleType window) {
+    mRmsWindow = juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(COMP_MAX_RMS_WINDOW), window);
+}
+
+template <typename SampleType>
+int Comp<SampleType>::getLatencySamples() const {
+    // Same rounding as the delay published by publishSettings()
+    const int delay = (int) ceil(mLookahead * mSampleRate) + getEqLatencySamples() + getDecimationLatencySamples();
+    if (mOversamplingFactor == 1)
+        return delay;
+    return delay + (int) std::round(mOversampler.getLatency());
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setDetectionDomain(CompAhrDomain domain) {
+    mDomain = domain;
+}
+
+template <typename SampleType>
+int Comp<SampleType>::getEqLatencySamples() const {
+    if (mEqSideChainBypass)
+        return 0;
+    // The EQ runs at the detector rate
+    return (int) ceil((double) eq.getLatencySamples() * mDecimationFactor / mOversamplingFactor);
+}
+
+template <typename SampleType>
+int Comp<SampleType>::getDecimationLatencySamples() const {
+    // The anti alias filter, then one control period for the interpolation. Only without oversampling
+    return mDecimationFactor > 1 ? mDecimator.getLatency() + mDecimationFactor : 0;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setEqBackend(EqualiserBackend backend, int partitionSize) {
+    if (backend == eq.getBackend() && partitionSize == eq.getPartitionSize())
+        return;
+    eq.setBackend(backend, partitionSize);
+    prepareDetector();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::designEqKernel(const std::array<FilterParams, EQ_NUM_BANDS>& params, const std::array<bool, EQ_NUM_BANDS>& bypass) {
+    eq.designKernel(params, bypass);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setEqSideChainBypass(bool bypass) {
+    mEqSideChainBypass = bypass;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setEqBandBypass(size_t index, bool bypass) {
+    eq.setBandBypass(index, bypass);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setEqBandParams(size_t index, FilterParams& params) {
+    eq.setBandParams(index, params);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::setDynamicEq(bool dynamicEq) {
+    mDynamicEq = dynamicEq;
+}
+
+template <typename SampleType>
+SvfType Comp<SampleType>::getDynamicBandType(FilterType type) {
+    switch (type) {
+        case LOWPASS:
+        case LOWSHELF:
+            return SVF_LOWSHELF;
+        case HIGHPASS:
+        case HIGHSHELF:
+            return SVF_HIGHSHELF;
+        default:
+            return SVF_PEAK;
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::publishSettings() {
+    auto& settings = mSettings.getWriteBuffer();
+    const double detectorRate = getDetectorRate();
+    
+    // In peak hold mode the hold is part of the detector window, the AHR stage only attacks and releases
+    const bool peakHold = mParams.estimationType == EstimationType::peakHold;
+    CompAhrParams<SampleType> ahrParams;
+    ahrParams.attack = mParams.attack;
+    ahrParams.hold = peakHold ? static_cast<SampleType>(0.0) : mParams.hold;
+    ahrParams.release = mParams.release;
+    ahrParams.threshold = mParams.threshold;
+    ahrParams.knee = mParams.knee;
+    ahrParams.ratio = mParams.ratio;
+    ahrParams.makeUpGain = mParams.makeUpGain;
+    ahrParams.gainTableSize = mGainTableSize;
+    settings.ahr = CompAhr<SampleType>::computeCoefficients(ahrParams, detectorRate);
+    mAhr.publishGainTable(settings.ahr);
+    // The lanes have no windowed peak detector, the window becomes a hold of the gain reduction
+    CompParams<SampleType> laneParams = mParams;
+    if (peakHold)
+        laneParams.hold = mLookahead + mParams.hold;
+    settings.lanes = CompBank<SampleType>::computeLaneCoefficients(laneParams, (double) mSampleRate * mOversamplingFactor, mRmsWindow);
+    // Only the bands changed since the last publish are designed again
+    settings.eq = eq.designCoefficients();
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        const FilterParams& params = eq.getBandParams(index);
+        settings.dynamicBandActive[index] = mDynamicEq && !eq.getBandBypass(index);
+        settings.dynamicBands[index] = SvfFilter<SampleType>::computeCoefficients(getDynamicBandType(params.type), params.freq,
+                                                                                  (double) mSampleRate * mOversamplingFactor, params.quality, 0.0);
+    }
+    
+    // Same time constants as juce::dsp::BallisticsFilter, times are in ms
+    const double expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / detectorRate;
+    settings.ballisticAttackCte = ballistic.attackTime < 1.0e-3 ? static_cast<SampleType>(0.0) : static_cast<SampleType>(std::exp(expFactor / ballistic.attackTime));
+    settings.ballisticReleaseCte = ballistic.releaseTime < 1.0e-3 ? static_cast<SampleType>(0.0) : static_cast<SampleType>(std::exp(expFactor / ballistic.releaseTime));
+    settings.peakHoldWindow = (int) ceil((mLookahead + mParams.hold) * detectorRate);
+    settings.rmsWindow = (int) ceil(mRmsWindow * detectorRate);
+    // Whole base rate samples, so that the reported latency is exact
+    settings.delaySamples = ((int) ceil(mLookahead * mSampleRate) + getEqLatencySamples() + getDecimationLatencySamples()) * mOversamplingFactor;
+    
+    settings.linkAmount = mLinkAmount;
+    settings.estimationType = mParams.estimationType;
+    settings.domain = mDomain;
+    settings.externalSideChain = mExternalSideChain;
+    settings.eqSideChainBypass = mEqSideChainBypass;
+    settings.dynamicEq = mDynamicEq;
+    settings.useSpecialisedKernels = mUseSpecialisedKernels;
+    mSettings.publish();
+}
+
+template <typename SampleType>
+void Comp<SampleType>::acquireSettings() {
+    if (mSettings.acquire())
+        applySettings(mSettings.getReadBuffer());
+}
+
+template <typename SampleType>
+void Comp<SampleType>::applySettings(const CompSettings<SampleType>& settings) {
+    mAhr.setCoefficients(settings.ahr);
+    mAhr.setDomain(settings.domain);
+    // The RMS detector outputs a mean power, the AHR stage smooths it as is and takes 10 * log10
+    mAhr.setLevelType(settings.estimationType == EstimationType::RMS ? COMP_LEVEL_POWER : COMP_LEVEL_AMPLITUDE);
+    for (int lane = 0; lane < mChannelBank.getNumCompressors(); lane++)
+        mChannelBank.setLaneCoefficients(lane, settings.lanes);
+    eq.setCoefficients(settings.eq);
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        const bool active = settings.dynamicBandActive[index];
+        if (active && !mDynamicBandActive[index])
+            mDynamicBands[index].reset();
+        mDynamicBandActive[index] = active;
+        mDynamicBands[index].setCoefficients(settings.dynamicBands[index]);
+    }
+    ballistic.attackCte = settings.ballisticAttackCte;
+    ballistic.releaseCte = settings.ballisticReleaseCte;
+    mPeakHold.setWindow(settings.peakHoldWindow);
+    mRms.setWindow(settings.rmsWindow);
+    mDelayLine.setDelaySamples(settings.delaySamples);
+    updateKernel(settings);
+}
+
+template <typename SampleType>
+template <EstimationType Type>
+typename Comp<SampleType>::Kernel Comp<SampleType>::selectKernel(bool hardKnee, bool hold) {
+    if (hardKnee)
+        return hold ? &Comp::template processKernel<Type, COMP_HARD_KNEE, true> : &Comp::template processKernel<Type, COMP_HARD_KNEE, false>;
+    return hold ? &Comp::template processKernel<Type, COMP_SOFT_KNEE, true> : &Comp::template processKernel<Type, COMP_SOFT_KNEE, false>;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::updateKernel(const CompSettings<SampleType>& settings) {
+    if (!settings.useSpecialisedKernels) {
+        mKernel = &Comp::processGenericKernel;
+        return;
+    }
+    const bool hardKnee = mAhr.getKneeType() == COMP_HARD_KNEE;
+    const bool hold = mAhr.hasHold();
+    switch (settings.estimationType) {
+        case EstimationType::RMS:
+            mKernel = selectKernel<EstimationType::RMS>(hardKnee, hold);
+            break;
+        case EstimationType::peakHold:
+            mKernel = selectKernel<EstimationType::peakHold>(hardKnee, hold);
+            break;
+        default:
+            mKernel = selectKernel<EstimationType::peak>(hardKnee, hold);
+            break;
+    }
+}
+
+template <typename SampleType>
+template <EstimationType Type>
+void Comp<SampleType>::processBallistics(const SampleType* input, SampleType* levels, size_t numSamples) {
+    if constexpr (Type == EstimationType::peakHold) {
+        mPeakHold.process(input, levels, numSamples);
+        return;
+    }
+    
+    if constexpr (Type == EstimationType::RMS) {
+        mRms.process(input, levels, numSamples);
+        return;
+    }
+    
+    const SampleType attackCte = ballistic.attackCte, releaseCte = ballistic.releaseCte;
+    SampleType state = ballistic.state;
+    for (size_t n = 0; n < numSamples; n++) {
+        const SampleType value = std::abs(input[n]);
+        const SampleType cte = value > state ? attackCte : releaseCte;
+        state = value + cte * (state - value);
+        levels[n] = state;
+    }
+    ballistic.state = state;
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processBallistics(const SampleType* input, SampleType* levels, size_t numSamples) {
+    const EstimationType estimationType = mSettings.getReadBuffer().estimationType;
+    if (estimationType == EstimationType::peakHold) {
+        mPeakHold.process(input, levels, numSamples);
+        return;
+    }
+    if (estimationType == EstimationType::RMS) {
+        mRms.process(input, levels, numSamples);
+        return;
+    }
+    for (size_t n = 0; n < numSamples; n++) {
+        const SampleType value = std::abs(input[n]);
+        const SampleType cte = value > ballistic.state ? ballistic.attackCte : ballistic.releaseCte;
+        ballistic.state = value + cte * (ballistic.state - value);
+        levels[n] = ballistic.state;
+    }
+}
+
+template <typename SampleType>
+template <EstimationType Type, CompKneeType Knee, bool Hold>
+void Comp<SampleType>::processKernel(const SampleType* sideChain, SampleType* gains, size_t numSamples) {
+    auto* levels = mSignalLevelBuffer.getWritePointer(0);
+    processBallistics<Type>(sideChain, levels, numSamples);
+    constexpr CompLevelType Level = Type == EstimationType::RMS ? COMP_LEVEL_POWER : COMP_LEVEL_AMPLITUDE;
+    mAhr.template processBlock<Knee, Hold, Level>(levels, gains, numSamples);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processGenericKernel(const SampleType* sideChain, SampleType* gains, size_t numSamples) {
+    processBallistics(sideChain, mSignalLevelBuffer.getWritePointer(0), numSamples);
+    
+    juce::dsp::AudioBlock<const SampleType> levelsBlock = juce::dsp::AudioBlock<SampleType>(mSignalLevelBuffer).getSubBlock(0, numSamples);
+    juce::dsp::AudioBlock<SampleType> gainsBlock(&gains, 1, numSamples);
+    juce::dsp::ProcessContextNonReplacing<SampleType> context_ahr(levelsBlock, gainsBlock);
+    mAhr.processBlock(context_ahr);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processBlock(juce::dsp::ProcessContextReplacing<SampleType>& context,
+                                    const juce::dsp::AudioBlock<const SampleType>& extSideChain) {
+    acquireSettings();
+    const bool external = mSettings.getReadBuffer().externalSideChain;
+    const auto& block = context.getOutputBlock();
+    const size_t numSamples = block.getNumSamples();
+    // A host may go over the prepared block size, every buffer and the delay line are sized for mMaxBlockSize
+    for (size_t start = 0; start < numSamples; start += (size_t) mMaxBlockSize) {
+        const size_t chunkSize = juce::jmin((size_t) mMaxBlockSize, numSamples - start);
+        const auto chunk = block.getSubBlock(start, chunkSize);
+        processChunk(chunk, external ? extSideChain.getSubBlock(start, chunkSize) : juce::dsp::AudioBlock<const SampleType>(chunk));
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processChunk(const juce::dsp::AudioBlock<SampleType>& block,
+                                    const juce::dsp::AudioBlock<const SampleType>& sideChain) {
+    if (mOversamplingFactor == 1) {
+        processGainStage(block, sideChain);
+        return;
+    }
+    
+    // In place on the oversampler storage, then down into the host block
+    auto oversampled = mOversampler.processUp(block);
+    if (mSettings.getReadBuffer().externalSideChain)
+        processGainStage(oversampled, mSideChainOversampler.processUp(sideChain));
+    else
+        processGainStage(oversampled, oversampled);
+    mOversampler.processDown(oversampled, block);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processGainStage(const juce::dsp::AudioBlock<SampleType>& block,
+                                        const juce::dsp::AudioBlock<const SampleType>& sideChain) {
+    const size_t blockSize = block.getNumSamples();
+    
+    auto* gains = mControlGainBuffer.getWritePointer(0);
+    const bool linked = mLinkMode == COMP_LINK_LINKED;
+    const bool eqBypass = mSettings.getReadBuffer().eqSideChainBypass;
+    
+    // The side chain may be the block itself, it is fully read before any gain is applied
+    if (linked) {
+        /* Fully linked : one detector on the average of the channels. The EQ is linear so it runs once on
+           the downmix instead of once per channel, whatever the channel count. */
+        auto* linkedSideChain = mSideChainBuffer.getWritePointer(0);
+        downmix(sideChain, linkedSideChain, blockSize);
+        if (mDecimationFactor > 1) {
+            processDecimatedSideChain(linkedSideChain, gains, blockSize);
+        } else {
+            if (!eqBypass)
+                eq.processBlock(juce::dsp::AudioBlock<SampleType>(mSideChainBuffer).getSubBlock(0, blockSize));
+            (this->*mKernel)(linkedSideChain, gains, blockSize);
+        }
+    } else {
+        processChannelSideChains(sideChain, blockSize);
+    }
+    
+    // Gains computed on the current side chain go to the input delayed by the lookahead
+    processDelay(block);
+    
+    if (mSettings.getReadBuffer().dynamicEq) {
+        processDynamicEq(block, blockSize);
+        return;
+    }
+    
+    if (mLinkMode == COMP_LINK_MID_SIDE && mNumChannels >= 2) {
+        const SampleType* midGains = mChannelGainBuffer.getReadPointer(0);
+        const SampleType* sideGains = mChannelGainBuffer.getReadPointer(1);
+        SampleType* left = block.getChannelPointer(0);
+        SampleType* right = block.getChannelPointer(1);
+        const SampleType half = static_cast<SampleType>(0.5);
+        for (size_t n = 0; n < blockSize; n++) {
+            const SampleType mid = half * (left[n] + right[n]) * midGains[n];
+            const SampleType side = half * (left[n] - right[n]) * sideGains[n];
+            left[n] = mid + side;
+            right[n] = mid - side;
+        }
+        for (int channel = 2; channel < mNumChannels; channel++)
+            juce::FloatVectorOperations::multiply(block.getChannelPointer((size_t) channel), midGains, (int) blockSize);
+        return;
+    }
+    
+    for (int channel = 0; channel < mNumChannels; channel++) {
+        const SampleType* channelGains = linked ? gains : mChannelGainBuffer.getReadPointer(channel);
+        juce::FloatVectorOperations::multiply(block.getChannelPointer((size_t) channel), channelGains, (int) blockSize);
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processDynamicEq(const juce::dsp::AudioBlock<SampleType>& block, size_t blockSize) {
+    const bool linked = mLinkMode == COMP_LINK_LINKED;
+    const bool midSide = mLinkMode == COMP_LINK_MID_SIDE && mNumChannels >= 2;
+    const int numCurves = linked ? 1 : (midSide ? 2 : mNumChannels);
+    auto* const* curves = linked ? mControlGainBuffer.getArrayOfWritePointers() : mChannelGainBuffer.getArrayOfWritePointers();
+    
+    // The bands only take the gain reduction, so that they sit at 0 dB at rest
+    const SampleType makeUpGain = mSettings.getReadBuffer().ahr.makeUpGain.linear;
+    for (int curve = 0; curve < numCurves; curve++)
+        juce::FloatVectorOperations::multiply(curves[curve], static_cast<SampleType>(1.0) / makeUpGain, (int) blockSize);
+    
+    // Left / right into mid / side in place, the filter states of channels 0 and 1 then follow mid and side
+    SampleType* left = block.getChannelPointer(0);
+    SampleType* right = midSide ? block.getChannelPointer(1) : nullptr;
+    const SampleType half = static_cast<SampleType>(0.5);
+    if (midSide) {
+        for (size_t n = 0; n < blockSize; n++) {
+            const SampleType mid = half * (left[n] + right[n]);
+            right[n] = half * (left[n] - right[n]);
+            left[n] = mid;
+        }
+    }
+    
+    for (int channel = 0; channel < mNumChannels; channel++) {
+        const SampleType* channelGains = curves[linked || channel >= numCurves ? 0 : channel];
+        for (size_t index = 0; index < EQ_NUM_BANDS; index++)
+            if (mDynamicBandActive[index])
+                mDynamicBands[index].processModulated(block.getChannelPointer((size_t) channel), channelGains, nullptr, blockSize, channel);
+    }
+    
+    if (midSide) {
+        for (size_t n = 0; n < blockSize; n++) {
+            const SampleType mid = left[n];
+            left[n] = mid + right[n];
+            right[n] = mid - right[n];
+        }
+    }
+    for (int channel = 0; channel < mNumChannels; channel++)
+        juce::FloatVectorOperations::multiply(block.getChannelPointer((size_t) channel), makeUpGain, (int) blockSize);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processChannelSideChains(const juce::dsp::AudioBlock<const SampleType>& sideChain, size_t blockSize) {
+    auto* const* sideChains = mChannelSideChainBuffer.getArrayOfWritePointers();
+    auto* const* channelGains = mChannelGainBuffer.getArrayOfWritePointers();
+    const auto& settings = mSettings.getReadBuffer();
+    const bool eqBypass = settings.eqSideChainBypass;
+    const SampleType linkAmount = settings.linkAmount;
+    int numLanes = mNumChannels;
+    const bool midSide = mLinkMode == COMP_LINK_MID_SIDE && mNumChannels >= 2;
+    const bool inPlace = !midSide && eqBypass && (int) sideChain.getNumChannels() >= mNumChannels;
+    
+    if (midSide) {
+        const SampleType* left = sideChain.getChannelPointer(0);
+        const SampleType* right = sideChain.getChannelPointer(juce::jmin((size_t) 1, sideChain.getNumChannels() - 1));
+        juce::FloatVectorOperations::add(sideChains[0], left, right, (int) blockSize);
+        juce::FloatVectorOperations::subtract(sideChains[1], left, right, (int) blockSize);
+        juce::FloatVectorOperations::multiply(sideChains[0], static_cast<SampleType>(0.5), (int) blockSize);
+        juce::FloatVectorOperations::multiply(sideChains[1], static_cast<SampleType>(0.5), (int) blockSize);
+        numLanes = 2;
+    } else if (inPlace) {
+        // Nothing to filter, the lanes read the side chain where it is
+        for (int channel = 0; channel < mNumChannels; channel++)
+            mSideChainPointers[(size_t) channel] = sideChain.getChannelPointer((size_t) channel);
+    } else {
+        const int numSideChainChannels = (int) sideChain.getNumChannels();
+        for (int channel = 0; channel < mNumChannels; channel++) {
+            // A side chain with fewer channels feeds its last one to the remaining channels
+            const int source = juce::jmin(channel, numSideChainChannels - 1);
+            juce::FloatVectorOperations::copy(sideChains[channel], sideChain.getChannelPointer((size_t) source), (int) blockSize);
+        }
+    }
+    
+    if (!eqBypass)
+        eq.processBlock(juce::dsp::AudioBlock<SampleType>(mChannelSideChainBuffer).getSubsetChannelBlock(0, (size_t) numLanes).getSubBlock(0, blockSize));
+    
+    // All the lanes in one pass
+    const SampleType* const* bankInputs = sideChains;
+    if (inPlace)
+        bankInputs = mSideChainPointers.data();
+    mChannelBank.processSideChain(bankInputs, channelGains, numLanes, blockSize);
+    
+    if (mLinkMode != COMP_LINK_PARTIAL || linkAmount <= static_cast<SampleType>(0.0))
+        return;
+    
+    // Pull each channel gain towards the smallest one, linearly in gain
+    auto* smallest = mControlGainBuffer.getWritePointer(0);
+    juce::FloatVectorOperations::copy(smallest, channelGains[0], (int) blockSize);
+    for (int channel = 1; channel < mNumChannels; channel++)
+        juce::FloatVectorOperations::min(smallest, smallest, channelGains[channel], (int) blockSize);
+    for (int channel = 0; channel < mNumChannels; channel++) {
+        juce::FloatVectorOperations::multiply(channelGains[channel], static_cast<SampleType>(1.0) - linkAmount, (int) blockSize);
+        juce::FloatVectorOperations::addWithMultiply(channelGains[channel], smallest, linkAmount, (int) blockSize);
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::downmix(const juce::dsp::AudioBlock<const SampleType>& sideChain, SampleType* destination, size_t blockSize) {
+    const int numSideChainChannels = (int) sideChain.getNumChannels();
+    juce::FloatVectorOperations::copy(destination, sideChain.getChannelPointer(0), (int) blockSize);
+    if (numSideChainChannels == 1)
+        return;
+    for (int channel = 1; channel < numSideChainChannels; channel++)
+        juce::FloatVectorOperations::add(destination, sideChain.getChannelPointer((size_t) channel), (int) blockSize);
+    juce::FloatVectorOperations::multiply(destination, static_cast<SampleType>(1.0) / static_cast<SampleType>(numSideChainChannels), (int) blockSize);
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processDecimatedSideChain(const SampleType* sideChain, SampleType* gains, size_t blockSize) {
+    const size_t firstOutput = mDecimator.getNextOutputIndex();
+    auto* const* decimated = mDecimatedBuffer.getArrayOfWritePointers();
+    // Downmixed already, only one channel to decimate, then the EQ runs at the detector rate
+    const size_t numDecimated = mDecimator.process(&sideChain, decimated, 1, blockSize);
+    if (!mSettings.getReadBuffer().eqSideChainBypass)
+        eq.processBlock(juce::dsp::AudioBlock<SampleType>(mDecimatedBuffer).getSubBlock(0, numDecimated));
+    
+    auto* decimatedGains = mDecimatedGainBuffer.getWritePointer(0);
+    (this->*mKernel)(decimated[0], decimatedGains, numDecimated);
+    
+    /* Back to audio rate : linear ramp from the previous control rate gain to the latest one over the
+       factor samples following each control rate sample, so the curve is continuous and causal. */
+    const size_t factor = (size_t) mDecimationFactor;
+    const SampleType step = static_cast<SampleType>(1.0) / static_cast<SampleType>(factor);
+    size_t nextUpdate = firstOutput, k = 0, n = 0;
+    while (n < blockSize) {
+        if (n == nextUpdate) {
+            jassert(k < numDecimated);
+            mPreviousGain = mCurrentGain;
+            mCurrentGain = decimatedGains[k++];
+            mGainRamp = 0;
+            nextUpdate += factor;
+        }
+        const size_t end = juce::jmin(blockSize, nextUpdate);
+        const SampleType delta = (mCurrentGain - mPreviousGain) * step;
+        for (size_t i = n; i < end; i++)
+            gains[i] = mPreviousGain + delta * static_cast<SampleType>(mGainRamp + (int) (i - n));
+        mGainRamp += (int) (end - n);
+        n = end;
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processBypass(juce::dsp::ProcessContextReplacing<SampleType>& context) {
+    // The lookahead can still change the delay while bypassed
+    acquireSettings();
+    const auto& block = context.getOutputBlock();
+    const size_t numSamples = block.getNumSamples();
+    for (size_t start = 0; start < numSamples; start += (size_t) mMaxBlockSize) {
+        const auto chunk = block.getSubBlock(start, juce::jmin((size_t) mMaxBlockSize, numSamples - start));
+        if (mOversamplingFactor > 1) {
+            // Through the same filters and delay as processBlock, so that bypassing does not move the signal
+            auto oversampled = mOversampler.processUp(chunk);
+            processDelay(oversampled);
+            mOversampler.processDown(oversampled, chunk);
+        } else {
+            processDelay(chunk);
+        }
+    }
+}
+
+template <typename SampleType>
+void Comp<SampleType>::processDelay(const juce::dsp::AudioBlock<SampleType>& block) {
+    if (mDelayLine.getDelaySamples() == 0)
+        return;
+    // Only fails on a block longer than prepared, the main path would then miss the latency reported to the host
+    const int result = mDelayLine.process(block);
+    jassert(result == 0);
+    juce::ignoreUnused(result);
+}
+
+template class Comp<float>;
+template class Comp<double>;
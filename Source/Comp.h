@@ -1,59 +1,259 @@
-/*
-  ==============================================================================
-    Comp.h
-    Author:  Quentin Prost
-  ==============================================================================
-*/
-
-#pragma once
-
-#include "JuceHeader.h"
-#include "CompAhr.h"
-#include "Equaliser.h"
-
-using EstimationType = juce::dsp::BallisticsFilterLevelCalculationType;
-
-template <typename SampleType>
-struct CompParams {
-    SampleType attack;
-    SampleType hold;
-    SampleType release;
-    SampleType threshold;
-    SampleType ratio;
-    SampleType knee;
-    SampleType makeUpGain;
-    EstimationType estimationType;
-};
-
-template <typename SampleType>
-class Comp {
-public:
-    Comp();
-    Comp(int sampleRate, int maxBlockSize);
-    ~Comp();
-    
-    void prepare(const juce::dsp::ProcessSpec& spec);
-    void setAttack(SampleType attack);
-    void setHold(SampleType hold);
-    void setRelease(SampleType release);
-    void setThreshold(SampleType threshold);
-    void setRatio(SampleType ratio);
-    void setKnee(SampleType knee);
-    void setMakeUpGain(SampleType makeUpGain);
-    void setExternalSideChain(bool value);
-    void setEstimationType(EstimationType type);
-    void setEqSideChainBypass(bool bypass);
-    void setEqBandBypass(size_t index, bool bypass);
-    void setEqBandParams(size_t index, FilterParams& params);
-    void processBlock(juce::dsp::ProcessContextNonReplacing<SampleType>& inputContext, juce::dsp::ProcessContextNonReplacing<SampleType>& sideChainContext);
-    SampleType processSample(SampleType input);
-public:
-    CompAhr<SampleType> mAhr;
-    juce::AudioBuffer<SampleType> mControlGainBuffer, mSignalLevelBuffer, mSideChainBuffer;
-    juce::dsp::BallisticsFilter<SampleType> ballistic;
-    Equaliser<SampleType> eq;
-    CompParams<SampleType> mParams = {0.01, 0.0, 0.1, -6.0, 2.0, 5.0, 0.0, EstimationType::peak};
-    int mSampleRate = 44100, mMaxBlockSize = 2048, mNumChannels = 2;
-    bool mEqSideChainBypass = true;
-    bool mExternalSideChain = false;
-};
+/*
+  ==============================================================================
+    Comp.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+#include "CompParams.h"
+#include "CompAhr.h"
+#include "Equaliser.h"
+#include "RingBuffer.h"
+#include "PeakHoldDetector.h"
+#include "RmsDetector.h"
+#include "Decimator.h"
+#include "Oversampler.h"
+#include "CompBank.h"
+#include "../Utilities/TripleBuffer.h"
+
+/* Set to 0 to always run the generic processing path (runtime checks on the estimation type,
+   knee type and hold stage), e.g. to measure the specialised kernels against it. */
+#ifndef COMP_USE_SPECIALISED_KERNELS
+#define COMP_USE_SPECIALISED_KERNELS 1
+#endif
+
+// Longest lookahead, in seconds. The delay line is allocated for it in prepare()
+#define COMP_MAX_LOOKAHEAD 0.02
+// Longest hold, in seconds, bounds the peak hold detector window together with COMP_MAX_LOOKAHEAD
+#define COMP_MAX_HOLD 0.5
+// Longest RMS window, in seconds
+#define COMP_MAX_RMS_WINDOW 0.5
+// Longest delay of a linear phase side chain EQ, in samples at the processing rate (largest decimation)
+#define COMP_MAX_EQ_LATENCY ((EQ_MAX_PARTITION_SIZE + EQ_FIR_LENGTH / 2) * COMP_DECIMATION_8)
+// Delay of the decimated gain curve at the largest factor, see CompDecimation
+#define COMP_MAX_DECIMATION_LATENCY (7 * COMP_DECIMATION_8)
+
+/* Multirate detection : the side chain is decimated (Decimator) and the EQ, level detector and AHR stage
+   run at sampleRate / factor, then the gain is linearly interpolated back to the audio rate.
+   AUTO picks the largest factor keeping the detector rate at 44.1 kHz or more (2 at 88.2 / 96 kHz, 4 at
+   176.4 / 192 kHz, 8 above). Timing error bounds against the full rate detector, with M the factor :
+   - constant delay of the gain curve : 7 * M audio samples (6 * M for the anti alias filter, M for the
+     interpolation), 0.15 ms at 96 kHz and 192 kHz in AUTO mode. The main path is delayed as much, so the
+     gain lines up with the audio like at the full rate, and getLatencySamples() grows with it.
+   - attack onsets and hold lengths are quantised to the detector period, error below M samples.
+   - time constants are recomputed at the detector rate and stay exact. Between two control rate points the
+     interpolation error on an exponential segment of time constant tau samples is below (M / tau)^2 / 8 of
+     the gain change, e.g. 5e-5 for a 1 ms attack at 96 kHz with M = 2.
+   - the detector only sees the side chain below about 0.6 of the detector Nyquist frequency (flat within
+     0.02 dB there, -6 dB at Nyquist), which keeps the whole audible band in AUTO mode. */
+enum CompDecimation {
+    COMP_DECIMATION_AUTO = 0,
+    COMP_DECIMATION_OFF = 1,
+    COMP_DECIMATION_2 = 2,
+    COMP_DECIMATION_4 = 4,
+    COMP_DECIMATION_8 = 8
+};
+
+/* Oversampled gain stage : the input (and the external side chain) is upsampled with the half-band filters
+   of Oversampler, the whole chain (side chain EQ, detector, AHR stage, lookahead delay and gain) runs at
+   sampleRate * factor, then the output is downsampled. The gain curve gets no images from fast attacks or
+   releases applied at the base rate. Decimation is ignored while oversampling. Adds Oversampler::getLatency(),
+   rounded, to the reported latency. */
+enum CompOversampling {
+    COMP_OVERSAMPLING_OFF = 1,
+    COMP_OVERSAMPLING_2 = 2,
+    COMP_OVERSAMPLING_4 = 4
+};
+
+/* How the channels share the gain reduction :
+   - LINKED    : one detector on the average of the channels, the same gain for all of them
+   - UNLINKED  : one detector and gain per channel
+   - PARTIAL   : per channel gains pulled towards the smallest of them by the link amount (0 = unlinked,
+                 1 = every channel gets the largest reduction)
+   - MID_SIDE  : one detector and gain for mid = (L + R) / 2 and one for side = (L - R) / 2, applied in
+                 the mid / side domain then back to left / right. Other channels get the mid gain.
+   The per channel modes run all the channels side by side in the SIMD lanes of a CompBank, so unlinked
+   stereo costs about the same as linked stereo. That chain is the CompBank one and differs from the linked
+   detector where the lanes cannot hold per channel history :
+   - RMS       : one pole mean square with the RMS window as time constant, instead of the sliding window
+   - peakHold  : peak detector, the lookahead + hold window holds the gain reduction instead
+   - the detection domain is always COMP_DOMAIN_LOG and the decimation setting is ignored, the lanes run at
+     the processing rate. */
+enum CompLinkMode {
+    COMP_LINK_LINKED = 0,
+    COMP_LINK_UNLINKED,
+    COMP_LINK_PARTIAL,
+    COMP_LINK_MID_SIDE
+};
+
+/* One pole peak level detector, same maths as juce::dsp::BallisticsFilter but processed by
+   Comp::processBallistics, where the estimation type can be fixed at compile time. */
+template <typename SampleType>
+struct CompBallistics {
+    SampleType attackTime; // in ms
+    SampleType releaseTime; // in ms
+    SampleType attackCte;
+    SampleType releaseCte;
+    SampleType state;
+};
+
+/* Everything the processing takes from the parameters, derived values included : built by
+   Comp::publishSettings() on the control side, picked up by the audio thread once per block. */
+template <typename SampleType>
+struct CompSettings {
+    CompAhrCoefficients<SampleType> ahr {};
+    CompBankLaneCoefficients<SampleType> lanes {}; // the same for every channel
+    EqualiserCoefficients<SampleType> eq {};
+    // Main path bands of the dynamic EQ, at the processing rate
+    std::array<SvfCoefficients<SampleType>, EQ_NUM_BANDS> dynamicBands {};
+    std::array<bool, EQ_NUM_BANDS> dynamicBandActive {};
+    SampleType ballisticAttackCte = 0.0, ballisticReleaseCte = 0.0;
+    int peakHoldWindow = 1, rmsWindow = 1; // in samples at the detector rate
+    int delaySamples = 0; // at the processing rate
+    SampleType linkAmount = 1.0;
+    EstimationType estimationType = EstimationType::peak;
+    CompAhrDomain domain = COMP_DOMAIN_LINEAR;
+    bool externalSideChain = false, eqSideChainBypass = true, dynamicEq = false, useSpecialisedKernels = COMP_USE_SPECIALISED_KERNELS;
+};
+
+template <typename SampleType>
+class Comp {
+public:
+    Comp();
+    Comp(int sampleRate, int maxBlockSize);
+    ~Comp();
+    
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    /* The setters below only store their value and never touch the processing state, so they can run on the
+       control thread while the audio thread is processing. publishSettings() then computes the derived
+       coefficients and filter designs there and hands them over without a lock, the next processBlock()
+       only copies them in. One control thread at a time : it is the single producer of the settings. The
+       structural ones (prepare, decimation, oversampling, link mode) still need the audio thread to be
+       stopped and publish on their own. */
+    void publishSettings();
+    void setAttack(SampleType attack);
+    void setHold(SampleType hold);
+    void setRelease(SampleType release);
+    void setThreshold(SampleType threshold);
+    void setRatio(SampleType ratio);
+    void setKnee(SampleType knee);
+    void setMakeUpGain(SampleType makeUpGain);
+    void setExternalSideChain(bool value);
+    void setEstimationType(EstimationType type);
+    void setDetectionDomain(CompAhrDomain domain);
+    void setSpecialisedKernels(bool useSpecialisedKernels);
+    // Points of the gain computer table, accuracy against cache footprint (see GainComputer.h). Linear domain only
+    void setGainTableSize(CompGainTableSize size);
+    // Delays the main path so that the gain reduction is applied ahead of the transients, in seconds
+    void setLookahead(SampleType lookahead);
+    int getLatencySamples() const;
+    // Integration window of the RMS estimation, in seconds
+    void setRmsWindow(SampleType window);
+    // Re-prepares the detector at the new rate : same threading rules as prepare()
+    void setDecimation(CompDecimation decimation);
+    int getDecimationFactor() const { return mDecimationFactor; }
+    // Re-prepares the whole processing at the new rate : same threading rules as prepare()
+    void setOversampling(CompOversampling oversampling);
+    int getOversamplingFactor() const { return mOversamplingFactor; }
+    // Re-prepares the detector when leaving or entering the linked mode with decimation on
+    void setLinkMode(CompLinkMode mode);
+    // Between 0 and 1, only used by COMP_LINK_PARTIAL
+    void setLinkAmount(SampleType amount);
+    void setEqSideChainBypass(bool bypass);
+    void setEqBandBypass(size_t index, bool bypass);
+    void setEqBandParams(size_t index, FilterParams& params);
+    /* Re-prepares the detector : same threading rules as prepare(). The linear phase EQ delays the side chain,
+       the main path is then delayed as much (whole base rate samples) and getLatencySamples() grows with it
+       while the side chain EQ is not bypassed. */
+    void setEqBackend(EqualiserBackend backend, int partitionSize);
+    /* Linear phase backend : designs the kernel of these bands on the calling thread and hands it over on its
+       own, outside publishSettings(). Expensive, see Equaliser::designKernel() : message thread only. */
+    void designEqKernel(const std::array<FilterParams, EQ_NUM_BANDS>& params, const std::array<bool, EQ_NUM_BANDS>& bypass);
+    /* Dynamic EQ : the gain curve no longer scales the whole signal, it modulates one SvfFilter per active
+       side chain EQ band on the main path instead, at the band frequency and quality, 0 dB at rest. The band
+       gain is the gain reduction alone, the make up gain is applied to the whole signal. Peaks and notches turn
+       into peaks, low pass and low shelf into low shelves, high pass and high shelf into high shelves. Mid /
+       side filters mid and side with their own gains, in the mid / side domain, other channels get the mid gain. */
+    void setDynamicEq(bool dynamicEq);
+    /* In place, the side chain block is only read and can be the context block itself. Blocks longer than the
+       prepared size are processed in several chunks. */
+    void processBlock(juce::dsp::ProcessContextReplacing<SampleType>& context, const juce::dsp::AudioBlock<const SampleType>& sideChain);
+    // Keeps the main path delayed while bypassed so that the reported latency stays valid
+    void processBypass(juce::dsp::ProcessContextReplacing<SampleType>& context);
+    SampleType processSample(SampleType input);
+private:
+    // Side chain (mono) to gains, the kernel in use is picked by updateKernel() when a parameter changes
+    using Kernel = void (Comp::*)(const SampleType* sideChain, SampleType* gains, size_t numSamples);
+    template <EstimationType Type, CompKneeType Knee, bool Hold>
+    void processKernel(const SampleType* sideChain, SampleType* gains, size_t numSamples);
+    void processGenericKernel(const SampleType* sideChain, SampleType* gains, size_t numSamples);
+    template <EstimationType Type>
+    void processBallistics(const SampleType* input, SampleType* levels, size_t numSamples);
+    void processBallistics(const SampleType* input, SampleType* levels, size_t numSamples);
+    template <EstimationType Type>
+    Kernel selectKernel(bool hardKnee, bool hold);
+    // Audio thread side of publishSettings(), copies only
+    void acquireSettings();
+    void applySettings(const CompSettings<SampleType>& settings);
+    void prepareProcessing();
+    void prepareDetector();
+    double getDetectorRate() const;
+    // Delay of the side chain EQ in base rate samples, rounded up
+    int getEqLatencySamples() const;
+    // Delay of the decimated gain curve in base rate samples, 0 at the full rate
+    int getDecimationLatencySamples() const;
+    // processBlock() on at most mMaxBlockSize samples
+    void processChunk(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>& sideChain);
+    // The lookahead (and latency compensation) delay of the main path, in place
+    void processDelay(const juce::dsp::AudioBlock<SampleType>& block);
+    // Everything after the oversampler, at sampleRate * mOversamplingFactor
+    void processGainStage(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>& sideChain);
+    // One gain curve per channel (or mid / side) in mChannelGainBuffer, for the per channel link modes
+    void processChannelSideChains(const juce::dsp::AudioBlock<const SampleType>& sideChain, size_t blockSize);
+    // Average of all the side chain channels, the linked detector input
+    void downmix(const juce::dsp::AudioBlock<const SampleType>& sideChain, SampleType* destination, size_t blockSize);
+    void processDecimatedSideChain(const SampleType* sideChain, SampleType* gains, size_t blockSize);
+    // The gain curves into the dynamic EQ bands, instead of the plain gain multiply
+    void processDynamicEq(const juce::dsp::AudioBlock<SampleType>& block, size_t blockSize);
+    static SvfType getDynamicBandType(FilterType type);
+    void updateKernel(const CompSettings<SampleType>& settings);
+    Kernel mKernel = &Comp::processGenericKernel;
+    bool mUseSpecialisedKernels = COMP_USE_SPECIALISED_KERNELS;
+    CompGainTableSize mGainTableSize = COMP_GAIN_TABLE_OFF;
+    CompAhrDomain mDomain = COMP_DOMAIN_LINEAR;
+    TripleBuffer<CompSettings<SampleType>> mSettings;
+public:
+    CompAhr<SampleType> mAhr;
+    juce::AudioBuffer<SampleType> mControlGainBuffer, mSignalLevelBuffer, mSideChainBuffer;
+    CompBallistics<SampleType> ballistic = {0.001, 0.01, 0.0, 0.0, 0.0};
+    Equaliser<SampleType> eq;
+    RingBuffer<SampleType> mDelayLine;
+    PeakHoldDetector<SampleType> mPeakHold;
+    RmsDetector<SampleType> mRms;
+    SampleType mRmsWindow = 0.3;
+    Decimator<SampleType> mDecimator;
+    juce::AudioBuffer<SampleType> mDecimatedBuffer, mDecimatedGainBuffer;
+    CompDecimation mDecimation = COMP_DECIMATION_OFF;
+    int mDecimationFactor = 1;
+    SampleType mPreviousGain = 1.0, mCurrentGain = 1.0; // control rate gains the audio rate ramp goes between
+    int mGainRamp = 0;
+    Oversampler<SampleType> mOversampler, mSideChainOversampler;
+    CompOversampling mOversampling = COMP_OVERSAMPLING_OFF;
+    int mOversamplingFactor = 1;
+    CompBank<SampleType> mChannelBank; // one lane per channel
+    juce::AudioBuffer<SampleType> mChannelSideChainBuffer, mChannelGainBuffer;
+    std::vector<const SampleType*> mSideChainPointers; // lanes reading the side chain without a copy
+    CompLinkMode mLinkMode = COMP_LINK_LINKED;
+    SampleType mLinkAmount = 1.0;
+    SampleType mLookahead = 0.0;
+    CompParams<SampleType> mParams = {0.01, 0.0, 0.1, -6.0, 2.0, 5.0, 0.0, EstimationType::peak};
+    int mSampleRate = 44100, mMaxBlockSize = 2048, mNumChannels = 2;
+    bool mEqSideChainBypass = true;
+    bool mDynamicEq = false;
+    std::array<SvfFilter<SampleType>, EQ_NUM_BANDS> mDynamicBands;
+    std::array<bool, EQ_NUM_BANDS> mDynamicBandActive {};
+    bool mExternalSideChain = false;
+};
@@ -1,204 +1,301 @@
-#include "CompAhr.h"
-
-template <typename SampleType>
-void CompAhr<SampleType>::prepare(const juce::dsp::ProcessSpec& spec) {
-    jassert(spec.sampleRate > 0);
-    jassert(spec.maximumBlockSize > 0);
-    mSampleRate = spec.sampleRate;
-    mEnvelope.resize(spec.maximumBlockSize);
-    std::fill(mEnvelope.begin(), mEnvelope.end(), static_cast<SampleType>(1.0));
-    setAttack(mParams.attack);
-    setRelease(mParams.release);
-    setHold(mParams.hold);
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setAttack(SampleType attack) {
-    mAttack.time = attack;
-    mAttack.counter = 0;
-    mAttack.samples = (unsigned int) ceil(attack * mSampleRate);
-    mAttack.value = static_cast<SampleType>(1.0 - exp(-2.2 / (attack * (float) mSampleRate)));
-    mAttack.coefs[0] = static_cast<SampleType>(1.0 - mAttack.value);
-    mAttack.coefs[1] = mAttack.value;
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setHold(SampleType hold) {
-    mHold.time = hold;
-    mHold.counter = 0;
-    mHold.samples = (unsigned int) ceil(hold * mSampleRate);
-    mHold.value = static_cast<SampleType>(1.0 - exp(-2.2 / (hold * (float) mSampleRate)));
-    mHold.coefs[0] = static_cast<SampleType>(1.0 - mHold.value);
-    mHold.coefs[1] = mHold.value;
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setRelease(SampleType release) {
-    mRelease.time = release;
-    mRelease.counter = 0;
-    mRelease.samples = (unsigned int) ceil(release * mSampleRate);
-    mRelease.value = static_cast<SampleType>(1.0 - exp(-2.2 / (release * (float) mSampleRate)));
-    mRelease.coefs[0] = static_cast<SampleType>(1.0 - mRelease.value);
-    mRelease.coefs[1] = mRelease.value;
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setThreshold(SampleType threshold) {
-    mThreshold.db = threshold;
-    mThreshold.linear = juce::Decibels::decibelsToGain(threshold);
-    mKnee.top = static_cast<SampleType>(mThreshold.db + 0.5*mKnee.width);
-    mKnee.bottom = static_cast<SampleType>(mThreshold.db - 0.5*mKnee.width);
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setKnee(SampleType knee) {
-    mKnee.type = knee < __FLT_EPSILON__ ? COMP_HARD_KNEE : COMP_SOFT_KNEE;
-    mKnee.width = knee;
-    mKnee.bottom = mThreshold.db - static_cast<SampleType>(0.5)*mKnee.width;
-    mKnee.top = mThreshold.db + static_cast<SampleType>(0.5)*mKnee.width;
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setRatio(SampleType ratio) {
-    mRatio.value = ratio;
-    mRatio.slope = static_cast<SampleType>(1.0 / mRatio.value - 1.0);
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setMakeUpGain(SampleType makeUpGain) {
-    mMakeUpGain.db = makeUpGain;
-    mMakeUpGain.linear = juce::Decibels::decibelsToGain(makeUpGain);
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::setParams(CompAhrParams<SampleType> *params) {
-    setAttack(params->attack);
-    setHold(params->hold);
-    setRelease(params->release);
-    setKnee(params->knee);
-    setRatio(params->ratio);
-    setMakeUpGain(params->makeUpGain);
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::applyHardKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
-    auto output = context.getOutputBlock();
-    auto blockSize = output.getNumSamples();
-    for (unsigned int n = 0; n < blockSize; n++) {
-        output.setSample(0, n, applyHardKneeSample(mEnvelope[n]));
-    }
-}
-
-template <typename SampleType>
-SampleType CompAhr<SampleType>::applyHardKneeSample(SampleType input) {
-    SampleType gainDb;
-    SampleType envelopeDb = juce::Decibels::gainToDecibels(input);
-    if (envelopeDb < mThreshold.db) {
-        return (1.0 * mMakeUpGain.linear);
-    } else {
-        gainDb = mRatio.slope * (envelopeDb - mThreshold.db);
-        return juce::Decibels::decibelsToGain(gainDb + mMakeUpGain.db);
-    }
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::applySoftKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
-    auto output = context.getOutputBlock();
-    auto blockSize = output.getNumSamples();
-    for (unsigned int n = 0; n < blockSize; n++) {
-        output.setSample(0, n, applySoftKneeSample(mEnvelope[n]));
-        //printf("gains ahr %i %f\n", n, output.getSample(0, n));
-    }
-}
-
-template <typename SampleType>
-SampleType CompAhr<SampleType>::applySoftKneeSample(SampleType input) {
-    SampleType gainDb;
-    SampleType envelopeDb = juce::Decibels::gainToDecibels(input);
-    if (envelopeDb < mKnee.bottom) {
-        return (1.0 * mMakeUpGain.linear);
-    } else if (envelopeDb > mKnee.top) {
-        gainDb = mRatio.slope * (envelopeDb - mThreshold.db);
-        return juce::Decibels::decibelsToGain(gainDb + mMakeUpGain.db);
-    } else {
-        gainDb = mRatio.slope * (envelopeDb - mThreshold.db + 0.5f * mKnee.width * (1.0f - cos((envelopeDb - mThreshold.db) / mKnee.width * M_PI)));
-        return (juce::Decibels::decibelsToGain(gainDb + mMakeUpGain.db));
-    }
-}
-
-template <typename SampleType>
-void CompAhr<SampleType>::processBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
-    SampleType input;
-    const auto& input_block = context.getInputBlock();
-    size_t blockSize = input_block.getNumSamples();
-    
-    for (size_t n = 0; n < blockSize; n++) {
-        input = input_block.getSample(0, (int) n);
-        if (input > current_envelope)
-            mState = STATE_ATTACK;
-        
-        switch (mState) {
-            case STATE_ATTACK:
-                mState = STATE_HOLD;
-                mHold.counter = 0;
-                current_envelope = mAttack.coefs[0] * current_envelope + mAttack.coefs[1] * input;
-                break;
-            case STATE_HOLD:
-                if (++mHold.counter > mHold.samples)
-                    mState = STATE_RELEASE;
-                break;
-            case STATE_RELEASE:
-                mHold.counter = 0;
-                current_envelope = mRelease.coefs[0] * current_envelope + mRelease.coefs[1] * input;
-                break;
-        }
-        mEnvelope[n] = current_envelope;
-        //printf("mEnvelope[%i]: %f\n", n, mEnvelope[n]);
-    }
-        
-    switch (mKnee.type) {
-        case COMP_HARD_KNEE:
-            applyHardKnee(context);
-            break;
-        default:
-            applySoftKnee(context);
-            break;
-    }
-    
-}
-
-template <typename SampleType>
-SampleType CompAhr<SampleType>::processSample(SampleType input) {
-    
-    if (input > current_envelope)
-        mState = STATE_ATTACK;
-        
-    switch (mState) {
-        case STATE_ATTACK:
-            mState = STATE_HOLD;
-            mHold.counter = 0;
-            current_envelope = mAttack.coefs[0] * current_envelope + mAttack.coefs[1] * input;
-            break;
-        case STATE_HOLD:
-            if (++mHold.counter > mHold.samples)
-                mState = STATE_RELEASE;
-            break;
-        case STATE_RELEASE:
-            mHold.counter = 0;
-            current_envelope = mRelease.coefs[0] * current_envelope + mRelease.coefs[1] * input;
-            break;
-    }
-    
-    
-    switch (mKnee.type) {
-        case COMP_HARD_KNEE:
-            return applyHardKneeSample(input);
-            break;
-        default:
-            return applySoftKneeSample(input);
-            break;
-    }
-}
-
-template class CompAhr<float>;
-template class CompAhr<double>;
+#include "CompAhr.h"
+
+template <typename SampleType>
+void CompAhr<SampleType>::prepare(const juce::dsp::ProcessSpec& spec) {
+    jassert(spec.sampleRate > 0);
+    jassert(spec.maximumBlockSize > 0);
+    mSampleRate = spec.sampleRate;
+    mEnvelope.resize(spec.maximumBlockSize);
+    std::fill(mEnvelope.begin(), mEnvelope.end(), static_cast<SampleType>(1.0));
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::reset() {
+    mState = STATE_RELEASE;
+    mHold.counter = 0;
+    current_envelope = static_cast<SampleType>(0.0);
+    mGainReduction = static_cast<SampleType>(0.0);
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::setDomain(CompAhrDomain domain) {
+    if (domain == mDomain)
+        return;
+    mDomain = domain;
+    // The two domains do not share their envelope, start again from a clean state
+    reset();
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::setLevelType(CompLevelType levelType) {
+    if (levelType == mLevelType)
+        return;
+    mLevelType = levelType;
+    // A linear domain envelope holding an amplitude means nothing as a power
+    reset();
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::computeTime(CompAhrParamState<SampleType>& state, SampleType time, double sampleRate) {
+    state.time = time;
+    state.counter = 0;
+    state.samples = (unsigned int) ceil(time * sampleRate);
+    state.value = static_cast<SampleType>(1.0 - exp(-2.2 / (time * (float) sampleRate)));
+    state.coefs[0] = static_cast<SampleType>(1.0 - state.value);
+    state.coefs[1] = state.value;
+    state.powers[0] = state.coefs[0];
+    for (int i = 1; i < COMP_AHR_DECAY_CHUNK; i++)
+        state.powers[i] = state.powers[i - 1] * state.coefs[0];
+}
+
+template <typename SampleType>
+CompAhrCoefficients<SampleType> CompAhr<SampleType>::computeCoefficients(const CompAhrParams<SampleType>& params, double sampleRate) {
+    CompAhrCoefficients<SampleType> coefficients {};
+    computeTime(coefficients.attack, params.attack, sampleRate);
+    computeTime(coefficients.hold, params.hold, sampleRate);
+    computeTime(coefficients.release, params.release, sampleRate);
+
+    coefficients.threshold.db = params.threshold;
+    coefficients.threshold.linear = juce::Decibels::decibelsToGain(params.threshold);
+    coefficients.knee.type = params.knee < __FLT_EPSILON__ ? COMP_HARD_KNEE : COMP_SOFT_KNEE;
+    coefficients.knee.width = params.knee;
+    coefficients.knee.bottom = params.threshold - static_cast<SampleType>(0.5) * params.knee;
+    coefficients.knee.top = params.threshold + static_cast<SampleType>(0.5) * params.knee;
+    coefficients.ratio.value = params.ratio;
+    coefficients.ratio.slope = static_cast<SampleType>(1.0 / params.ratio - 1.0);
+    coefficients.makeUpGain.db = params.makeUpGain;
+    coefficients.makeUpGain.linear = juce::Decibels::decibelsToGain(params.makeUpGain);
+
+    auto& curve = coefficients.curve;
+    curve.threshold = params.threshold;
+    curve.slope = coefficients.ratio.slope;
+    curve.halfWidth = static_cast<SampleType>(0.5) * params.knee;
+    curve.widthToPi = coefficients.knee.type == COMP_SOFT_KNEE ? static_cast<SampleType>(M_PI) / params.knee : static_cast<SampleType>(0.0);
+    curve.makeUpGain = params.makeUpGain;
+    coefficients.tableSize = params.gainTableSize;
+    return coefficients;
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::setCoefficients(const CompAhrCoefficients<SampleType>& coefficients) {
+    // A hold in progress ends at the new hold length at the latest
+    const unsigned int holdCounter = juce::jmin(mHold.counter, coefficients.hold.samples);
+    mAttack = coefficients.attack;
+    mHold = coefficients.hold;
+    mHold.counter = holdCounter;
+    mRelease = coefficients.release;
+    mThreshold = coefficients.threshold;
+    mMakeUpGain = coefficients.makeUpGain;
+    mRatio = coefficients.ratio;
+    mKnee = coefficients.knee;
+    mCurve = coefficients.curve;
+    // Published before the coefficients, so it is there unless a newer one already replaced it
+    mGainTables.acquire();
+    mAppliedTableVersion = coefficients.tableVersion;
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::publishGainTable(CompAhrCoefficients<SampleType>& coefficients) {
+    const auto& curve = coefficients.curve;
+    const bool softKnee = coefficients.knee.type == COMP_SOFT_KNEE;
+    const bool sameTable = mTableVersion > 0 && coefficients.tableSize == mTableSize && softKnee == mTableSoftKnee
+                           && curve.threshold == mTableCurve.threshold && curve.slope == mTableCurve.slope
+                           && curve.halfWidth == mTableCurve.halfWidth && curve.makeUpGain == mTableCurve.makeUpGain;
+    if (!sameTable) {
+        mTableCurve = curve;
+        mTableSoftKnee = softKnee;
+        mTableSize = coefficients.tableSize;
+        auto& table = mGainTables.getWriteBuffer();
+        buildGainTable(table, mTableCurve, mTableSoftKnee, static_cast<int>(mTableSize));
+        table.version = ++mTableVersion;
+        mGainTables.publish();
+    }
+    coefficients.tableVersion = mTableVersion;
+}
+
+template <typename SampleType>
+SampleType CompAhr<SampleType>::levelToDb(SampleType level) const {
+    return mLevelType == COMP_LEVEL_POWER ? fastPowerToDecibels(level) : fastGainToDecibels(level);
+}
+
+template <typename SampleType>
+template <CompLevelType Level>
+void CompAhr<SampleType>::applyHardKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
+    auto output = context.getOutputBlock();
+    computeHardKneeGains<SampleType, Level>(mEnvelope.data(), output.getChannelPointer(0), output.getNumSamples(), mCurve);
+}
+
+template <typename SampleType>
+SampleType CompAhr<SampleType>::applyHardKneeSample(SampleType input) {
+    if (const auto* table = getGainTable())
+        return mLevelType == COMP_LEVEL_POWER ? gainFromTable<SampleType, COMP_LEVEL_POWER>(input, *table) : gainFromTable(input, *table);
+    return fastDecibelsToGain(hardKneeGainDb(levelToDb(input), mCurve) + mCurve.makeUpGain);
+}
+
+template <typename SampleType>
+template <CompLevelType Level>
+void CompAhr<SampleType>::applySoftKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
+    auto output = context.getOutputBlock();
+    computeSoftKneeGains<SampleType, Level>(mEnvelope.data(), output.getChannelPointer(0), output.getNumSamples(), mCurve);
+}
+
+template <typename SampleType>
+SampleType CompAhr<SampleType>::applySoftKneeSample(SampleType input) {
+    if (const auto* table = getGainTable())
+        return mLevelType == COMP_LEVEL_POWER ? gainFromTable<SampleType, COMP_LEVEL_POWER>(input, *table) : gainFromTable(input, *table);
+    return fastDecibelsToGain(softKneeGainDb(levelToDb(input), mCurve) + mCurve.makeUpGain);
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::processAhr(const SampleType* input, SampleType* envelope, size_t numSamples, SampleType& state) {
+    /* Same state machine as a per sample switch, but processed in runs :
+       - attack  : one sample each time the input rises above the envelope, then hold
+       - hold    : the envelope is frozen for mHold.samples samples, only scan for their end or a new attack
+       - release : one pole recursion until the input rises above the envelope, stretches of
+                   constant input (e.g. silence) use the closed form x + (env - x) * r^k
+       input and envelope may point to the same buffer. */
+    SampleType envelopeValue = state;
+    size_t n = 0;
+    while (n < numSamples) {
+        if (input[n] > envelopeValue) {
+            envelopeValue = mAttack.coefs[0] * envelopeValue + mAttack.coefs[1] * input[n];
+            envelope[n++] = envelopeValue;
+            mState = STATE_HOLD;
+            mHold.counter = 0;
+            continue;
+        }
+        
+        if (mState == STATE_HOLD) {
+            const size_t holdEnd = juce::jmin(numSamples, n + (size_t) (mHold.samples - mHold.counter));
+            size_t end = n;
+            while (end < holdEnd && !(input[end] > envelopeValue))
+                end++;
+            std::fill(envelope + n, envelope + end, envelopeValue);
+            mHold.counter += (unsigned int) (end - n);
+            n = end;
+            if (mHold.counter >= mHold.samples) {
+                mState = STATE_RELEASE;
+                mHold.counter = 0;
+            }
+            continue;
+        }
+        
+        mState = STATE_RELEASE;
+        const SampleType target = input[n];
+        size_t end = n + 1;
+        while (end < numSamples && input[end] == target)
+            end++;
+        
+        // target <= envelope, the decay never crosses it so no attack can happen before end
+        if (end - n >= COMP_AHR_DECAY_CHUNK) {
+            SampleType distance = envelopeValue - target;
+            for (; n + COMP_AHR_DECAY_CHUNK <= end; n += COMP_AHR_DECAY_CHUNK) {
+                for (int i = 0; i < COMP_AHR_DECAY_CHUNK; i++)
+                    envelope[n + (size_t) i] = target + distance * mRelease.powers[i];
+                distance *= mRelease.powers[COMP_AHR_DECAY_CHUNK - 1];
+            }
+            envelopeValue = target + distance;
+        }
+        for (; n < end; n++) {
+            envelopeValue = mRelease.coefs[0] * envelopeValue + mRelease.coefs[1] * target;
+            envelope[n] = envelopeValue;
+        }
+    }
+    state = envelopeValue;
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::processAttackRelease(const SampleType* input, SampleType* envelope, size_t numSamples, SampleType& state) {
+    // Hold free kernel, the attack / release choice is a select so the loop has no branch
+    SampleType envelopeValue = state;
+    for (size_t n = 0; n < numSamples; n++) {
+        const SampleType value = input[n];
+        const bool rising = value > envelopeValue;
+        const SampleType coef0 = rising ? mAttack.coefs[0] : mRelease.coefs[0];
+        const SampleType coef1 = rising ? mAttack.coefs[1] : mRelease.coefs[1];
+        envelopeValue = coef0 * envelopeValue + coef1 * value;
+        envelope[n] = envelopeValue;
+    }
+    state = envelopeValue;
+    mState = STATE_RELEASE;
+    mHold.counter = 0;
+}
+
+template <typename SampleType>
+template <CompLevelType Level>
+void CompAhr<SampleType>::processLogDomain(const SampleType* levels, SampleType* gains, size_t numSamples) {
+    auto* reduction = mEnvelope.data();
+    switch (mKnee.type) {
+        case COMP_HARD_KNEE:
+            computeHardKneeReduction<SampleType, Level>(levels, reduction, numSamples, mCurve);
+            break;
+        default:
+            computeSoftKneeReduction<SampleType, Level>(levels, reduction, numSamples, mCurve);
+            break;
+    }
+    processAhr(reduction, reduction, numSamples, mGainReduction);
+    computeGainsFromReduction(reduction, gains, numSamples, mCurve.makeUpGain);
+}
+
+template <typename SampleType>
+void CompAhr<SampleType>::processBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
+    if (mLevelType == COMP_LEVEL_POWER)
+        processGenericBlock<COMP_LEVEL_POWER>(context);
+    else
+        processGenericBlock<COMP_LEVEL_AMPLITUDE>(context);
+}
+
+template <typename SampleType>
+template <CompLevelType Level>
+void CompAhr<SampleType>::processGenericBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
+    const auto& inputBlock = context.getInputBlock();
+    auto output = context.getOutputBlock();
+    size_t blockSize = inputBlock.getNumSamples();
+    
+    if (mDomain == COMP_DOMAIN_LOG) {
+        processLogDomain<Level>(inputBlock.getChannelPointer(0), output.getChannelPointer(0), blockSize);
+        return;
+    }
+    
+    processAhr(inputBlock.getChannelPointer(0), mEnvelope.data(), blockSize, current_envelope);
+    
+    if (const auto* table = getGainTable()) {
+        computeGainsFromTable<SampleType, Level>(mEnvelope.data(), output.getChannelPointer(0), blockSize, *table);
+        return;
+    }
+    
+    switch (mKnee.type) {
+        case COMP_HARD_KNEE:
+            applyHardKnee<Level>(context);
+            break;
+        default:
+            applySoftKnee<Level>(context);
+            break;
+    }
+    
+}
+
+template <typename SampleType>
+SampleType CompAhr<SampleType>::processSample(SampleType input) {
+    
+    if (mDomain == COMP_DOMAIN_LOG) {
+        const SampleType levelDb = levelToDb(input);
+        SampleType reduction = mKnee.type == COMP_HARD_KNEE ? -hardKneeGainDb(levelDb, mCurve) : -softKneeGainDb(levelDb, mCurve);
+        processAhr(&reduction, &reduction, 1, mGainReduction);
+        return fastDecibelsToGain(mCurve.makeUpGain - mGainReduction);
+    }
+    
+    processAhr(&input, &input, 1, current_envelope);
+    
+    switch (mKnee.type) {
+        case COMP_HARD_KNEE:
+            return applyHardKneeSample(current_envelope);
+            break;
+        default:
+            return applySoftKneeSample(current_envelope);
+            break;
+    }
+}
+
+template class CompAhr<float>;
+template class CompAhr<double>;
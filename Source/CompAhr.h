@@ -1,112 +1,216 @@
-/*
-  ==============================================================================
-    Ahr.h
-    Created: 13 Jun 2023 12:01:04pm
-    Author:  Quentin Prost
-
-  ==============================================================================
-*/
-#pragma once
-
-#include "JuceHeader.h"
-
-enum CompKneeType {
-    COMP_HARD_KNEE,
-    COMP_SOFT_KNEE
-};
-
-enum CompAhrState {
-    STATE_ATTACK,
-    STATE_HOLD,
-    STATE_RELEASE
-};
-
-template <typename SampleType>
-struct CompAhrParams {
-    SampleType attack; // in seconds
-    SampleType hold; // in seconds
-    SampleType release; // in seconds
-    SampleType threshold; // in dB
-    SampleType knee; // in dB
-    SampleType ratio; // in dB
-    SampleType makeUpGain; // in dB
-};
-
-template <typename SampleType>
-struct CompAhrKnee {
-    SampleType width;
-    SampleType top;
-    SampleType bottom;
-    CompKneeType type;
-};
-
-template <typename SampleType>
-struct CompAhrScaleType {
-    SampleType db;
-    SampleType linear;
-};
-
-template <typename SampleType>
-struct CompAhrParamState {
-    SampleType time;
-    unsigned int counter;
-    unsigned int samples;
-    SampleType value;
-    SampleType coefs[2];
-};
-
-template <typename SampleType>
-struct CompAhrRatio {
-    SampleType value;
-    SampleType slope;
-};
-
-template <typename SampleType>
-struct CompAhrEnvelope {
-    SampleType target;
-    SampleType dynamic;
-};
-
-template <typename SampleType>
-class CompAhr {
-    
-public:
-    CompAhr() {
-        setParams(&mParams);
-    }
-    CompAhr(int sampleRate, int maxBlockSize) {
-        mSampleRate = sampleRate;
-        mEnvelope.resize(maxBlockSize);
-        setParams(&mParams);
-    }
-    ~CompAhr() {};
-    void prepare(const juce::dsp::ProcessSpec& spec);
-    void reset();
-    void setAttack(SampleType attack);
-    void setHold(SampleType hold);
-    void setRelease(SampleType release);
-    void setThreshold(SampleType threshold);
-    void setKnee(SampleType knee);
-    void setRatio(SampleType ratio);
-    void setMakeUpGain(SampleType makeUpGain);
-    void setParams(CompAhrParams<SampleType> *params);
-    
-    void processBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
-    SampleType processSample(SampleType input);
-private:
-    
-    void applyHardKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
-    void applySoftKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
-    SampleType applyHardKneeSample(SampleType envelopeDb);
-    SampleType applySoftKneeSample(SampleType envelopeDb);
-    
-    CompAhrParams<SampleType> mParams = {0.001, 0.0, 0.1, -6.0, 6.0, 2.0, 0.0};
-    CompAhrState mState = STATE_RELEASE;
-    CompAhrParamState<SampleType> mAttack, mHold, mRelease;
-    CompAhrScaleType<SampleType> mThreshold, mMakeUpGain;
-    CompAhrRatio<SampleType> mRatio;
-    CompAhrKnee<SampleType> mKnee;
-    SampleType current_envelope;
-    std::vector<SampleType> mEnvelope;
-    int mSampleRate = 44100;
-};
+/*
+  ==============================================================================
+    Ahr.h
+    Created: 13 Jun 2023 12:01:04pm
+    Author:  Quentin Prost
+
+  ==============================================================================
+*/
+#pragma once
+
+#include "JuceHeader.h"
+#include "GainComputer.h"
+#include "../Utilities/TripleBuffer.h"
+
+// Release stretches with a constant input are filled with a closed form decay, this many samples at a time
+#define COMP_AHR_DECAY_CHUNK 8
+
+enum CompKneeType {
+    COMP_HARD_KNEE,
+    COMP_SOFT_KNEE
+};
+
+/* Where the attack / hold / release smoothing happens :
+   - linear : on the detector level, then the static curve is applied per sample (log + exp)
+   - log    : the detector level goes to dB once, the smoothing runs on the gain reduction in dB
+              and only the final dB to gain conversion is left. Attack and release then behave
+              the same whatever the level. The gain table is not used in this mode. */
+enum CompAhrDomain {
+    COMP_DOMAIN_LINEAR,
+    COMP_DOMAIN_LOG
+};
+
+// Number of points of the gain computer lookup table, trades accuracy for cache footprint (see GainComputer.h)
+enum CompGainTableSize {
+    COMP_GAIN_TABLE_OFF = 0,
+    COMP_GAIN_TABLE_256 = 256,
+    COMP_GAIN_TABLE_1024 = 1024,
+    COMP_GAIN_TABLE_4096 = 4096
+};
+
+enum CompAhrState {
+    STATE_ATTACK,
+    STATE_HOLD,
+    STATE_RELEASE
+};
+
+template <typename SampleType>
+struct CompAhrParams {
+    SampleType attack; // in seconds
+    SampleType hold; // in seconds
+    SampleType release; // in seconds
+    SampleType threshold; // in dB
+    SampleType knee; // in dB
+    SampleType ratio; // in dB
+    SampleType makeUpGain; // in dB
+    CompGainTableSize gainTableSize = COMP_GAIN_TABLE_OFF;
+};
+
+template <typename SampleType>
+struct CompAhrKnee {
+    SampleType width;
+    SampleType top;
+    SampleType bottom;
+    CompKneeType type;
+};
+
+template <typename SampleType>
+struct CompAhrScaleType {
+    SampleType db;
+    SampleType linear;
+};
+
+template <typename SampleType>
+struct CompAhrParamState {
+    SampleType time;
+    unsigned int counter;
+    unsigned int samples;
+    SampleType value;
+    SampleType coefs[2];
+    SampleType powers[COMP_AHR_DECAY_CHUNK]; // coefs[0]^1 ... coefs[0]^COMP_AHR_DECAY_CHUNK
+};
+
+template <typename SampleType>
+struct CompAhrRatio {
+    SampleType value;
+    SampleType slope;
+};
+
+template <typename SampleType>
+struct CompAhrEnvelope {
+    SampleType target;
+    SampleType dynamic;
+};
+
+/* Everything derived from CompAhrParams. Computed away from the audio thread with computeCoefficients()
+   (exp, dB conversions) and publishGainTable(), then applied there with setCoefficients() (copies only). */
+template <typename SampleType>
+struct CompAhrCoefficients {
+    CompAhrParamState<SampleType> attack, hold, release;
+    CompAhrScaleType<SampleType> threshold, makeUpGain;
+    CompAhrRatio<SampleType> ratio;
+    CompAhrKnee<SampleType> knee;
+    GainComputerCurve<SampleType> curve;
+    CompGainTableSize tableSize = COMP_GAIN_TABLE_OFF;
+    unsigned int tableVersion = 0; // gain table matching these coefficients, set by CompAhr::publishGainTable()
+};
+
+template <typename SampleType>
+class CompAhr {
+    
+public:
+    // Unity gain until the first setCoefficients()
+    CompAhr() {}
+    CompAhr(int sampleRate, int maxBlockSize) {
+        mSampleRate = sampleRate;
+        mEnvelope.resize(maxBlockSize);
+    }
+    ~CompAhr() {};
+    // Sizes the envelope, the coefficients are kept : times follow the rate with the next setCoefficients()
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+    static CompAhrCoefficients<SampleType> computeCoefficients(const CompAhrParams<SampleType>& params, double sampleRate);
+    /* Audio thread side : no maths, the hold counter carries on. Also picks up the latest gain table, which is
+       only used while it was built for these coefficients, the exact curve runs otherwise. */
+    void setCoefficients(const CompAhrCoefficients<SampleType>& coefficients);
+    /* Control thread side : builds the gain table of coefficients.tableSize points for these coefficients and tags
+       both with the same version, so that the audio thread never pairs a table with the coefficients of another
+       publish. The last table is reused while the curve and the size stay the same. Call it before handing the
+       coefficients over, from one thread only. */
+    void publishGainTable(CompAhrCoefficients<SampleType>& coefficients);
+    void setDomain(CompAhrDomain domain);
+    // Amplitude or mean power input, set by Comp from its estimation type
+    void setLevelType(CompLevelType levelType);
+    
+    CompKneeType getKneeType() const { return mKnee.type; }
+    bool hasHold() const { return mHold.samples > 0; }
+    
+    void processBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
+    /* Same processing as processBlock with the knee type, the hold stage and the level type fixed at compile
+       time, the caller is responsible for picking the variant matching getKneeType(), hasHold() and setLevelType(). */
+    template <CompKneeType Knee, bool Hold, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+    void processBlock(const SampleType* levels, SampleType* gains, size_t numSamples);
+    SampleType processSample(SampleType input);
+private:
+    
+    void processAhr(const SampleType* input, SampleType* envelope, size_t numSamples, SampleType& state);
+    void processAttackRelease(const SampleType* input, SampleType* envelope, size_t numSamples, SampleType& state);
+    template <bool Hold>
+    void processEnvelope(const SampleType* input, SampleType* envelope, size_t numSamples, SampleType& state) {
+        if constexpr (Hold)
+            processAhr(input, envelope, numSamples, state);
+        else
+            processAttackRelease(input, envelope, numSamples, state);
+    }
+    template <CompLevelType Level>
+    void processGenericBlock(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
+    template <CompLevelType Level>
+    void processLogDomain(const SampleType* levels, SampleType* gains, size_t numSamples);
+    template <CompLevelType Level>
+    void applyHardKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
+    template <CompLevelType Level>
+    void applySoftKnee(const juce::dsp::ProcessContextNonReplacing<SampleType>& context);
+    SampleType levelToDb(SampleType level) const;
+    SampleType applyHardKneeSample(SampleType envelopeDb);
+    SampleType applySoftKneeSample(SampleType envelopeDb);
+    static void computeTime(CompAhrParamState<SampleType>& state, SampleType time, double sampleRate);
+    // The table to use this block, nullptr when it is off or not built for the applied coefficients
+    const GainComputerTable<SampleType>* getGainTable() const {
+        const auto& table = mGainTables.getReadBuffer();
+        return table.size > 0 && table.version == mAppliedTableVersion ? &table : nullptr;
+    }
+    
+    CompAhrState mState = STATE_RELEASE;
+    CompAhrParamState<SampleType> mAttack {}, mHold {}, mRelease {};
+    CompAhrScaleType<SampleType> mThreshold {}, mMakeUpGain {};
+    CompAhrRatio<SampleType> mRatio {};
+    CompAhrKnee<SampleType> mKnee {};
+    GainComputerCurve<SampleType> mCurve;
+    TripleBuffer<GainComputerTable<SampleType>> mGainTables;
+    // The last published table, control thread side
+    GainComputerCurve<SampleType> mTableCurve;
+    bool mTableSoftKnee = true;
+    CompGainTableSize mTableSize = COMP_GAIN_TABLE_OFF;
+    unsigned int mTableVersion = 0; // last published, control thread side
+    unsigned int mAppliedTableVersion = 0; // of the applied coefficients, audio thread side
+    CompAhrDomain mDomain = COMP_DOMAIN_LINEAR;
+    CompLevelType mLevelType = COMP_LEVEL_AMPLITUDE;
+    SampleType current_envelope = 0.0;
+    SampleType mGainReduction = 0.0; // smoothed gain reduction in dB, log domain only
+    std::vector<SampleType> mEnvelope;
+    int mSampleRate = 44100;
+};
+
+template <typename SampleType>
+template <CompKneeType Knee, bool Hold, CompLevelType Level>
+void CompAhr<SampleType>::processBlock(const SampleType* levels, SampleType* gains, size_t numSamples) {
+    if (mDomain == COMP_DOMAIN_LOG) {
+        auto* reduction = mEnvelope.data();
+        if constexpr (Knee == COMP_HARD_KNEE)
+            computeHardKneeReduction<SampleType, Level>(levels, reduction, numSamples, mCurve);
+        else
+            computeSoftKneeReduction<SampleType, Level>(levels, reduction, numSamples, mCurve);
+        processEnvelope<Hold>(reduction, reduction, numSamples, mGainReduction);
+        computeGainsFromReduction(reduction, gains, numSamples, mCurve.makeUpGain);
+        return;
+    }
+    
+    processEnvelope<Hold>(levels, mEnvelope.data(), numSamples, current_envelope);
+    
+    if (const auto* table = getGainTable())
+        computeGainsFromTable<SampleType, Level>(mEnvelope.data(), gains, numSamples, *table);
+    else if constexpr (Knee == COMP_HARD_KNEE)
+        computeHardKneeGains<SampleType, Level>(mEnvelope.data(), gains, numSamples, mCurve);
+    else
+        computeSoftKneeGains<SampleType, Level>(mEnvelope.data(), gains, numSamples, mCurve);
+}
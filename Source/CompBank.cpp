@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+    CompBank.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "CompBank.h"
+
+template <typename SampleType>
+CompBank<SampleType>::CompBank() {
+}
+
+template <typename SampleType>
+CompBank<SampleType>::~CompBank() {
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::prepare(double sampleRate, int maxBlockSize, int numCompressors) {
+    mSampleRate = sampleRate;
+    mMaxBlockSize = (size_t) maxBlockSize;
+    mNumCompressors = numCompressors;
+
+    const size_t numGroups = ((size_t) numCompressors + laneCount - 1) / laneCount;
+    mGroups.resize(numGroups);
+    mParams.resize(numGroups * laneCount, {0.01, 0.0, 0.1, -6.0, 2.0, 5.0, 0.0, EstimationType::peak});
+
+    // One extra register so that the scratch can start on a SIMD boundary
+    const size_t scratchSize = mMaxBlockSize * laneCount + laneCount;
+    mSideChainStorage.allocate(scratchSize, true);
+    mGainStorage.allocate(scratchSize, true);
+    mSideChain = Register::getNextSIMDAlignedPtr(mSideChainStorage.get());
+    mGains = Register::getNextSIMDAlignedPtr(mGainStorage.get());
+
+    for (int i = 0; i < (int) mParams.size(); i++)
+        updateLanes(i);
+    reset();
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::reset() {
+    for (auto& lanes : mGroups) {
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            lanes.ballisticState[lane] = static_cast<SampleType>(0.0);
+            lanes.reduction[lane] = static_cast<SampleType>(0.0);
+            lanes.holdCounter[lane] = lanes.holdSamples[lane] + static_cast<SampleType>(1.0);
+        }
+    }
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::setParams(int index, const CompParams<SampleType>& params) {
+    jassert(index >= 0 && index < mNumCompressors);
+    mParams[(size_t) index] = params;
+    updateLanes(index);
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::updateLanes(int index) {
+    setLaneCoefficients(index, computeLaneCoefficients(mParams[(size_t) index], mSampleRate));
+}
+
+template <typename SampleType>
+CompBankLaneCoefficients<SampleType> CompBank<SampleType>::computeLaneCoefficients(const CompParams<SampleType>& params, double sampleRate,
+                                                                                   SampleType rmsWindow) {
+    CompBankLaneCoefficients<SampleType> coefficients;
+
+    // Peak lanes use the Comp peak follower times, RMS lanes a one pole mean square over the RMS window
+    // rather than the windowed RmsDetector of Comp, whose history would not fit in registers. Times in ms
+    const bool rms = params.estimationType == EstimationType::RMS;
+    const double expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+    const double attackTime = rms ? 1000.0 * (double) rmsWindow : 0.001;
+    const double releaseTime = rms ? 1000.0 * (double) rmsWindow : 0.01;
+    coefficients.ballisticAttackCte = attackTime < 1.0e-3 ? static_cast<SampleType>(0.0) : static_cast<SampleType>(std::exp(expFactor / attackTime));
+    coefficients.ballisticReleaseCte = releaseTime < 1.0e-3 ? static_cast<SampleType>(0.0) : static_cast<SampleType>(std::exp(expFactor / releaseTime));
+    coefficients.rms = rms ? static_cast<SampleType>(1.0) : static_cast<SampleType>(0.0);
+    coefficients.levelToDb = static_cast<SampleType>(rms ? 3.01029995663981195214 : 6.02059991327962390427);
+
+    // Same coefficients as CompAhr, times are in seconds
+    const double attack = 1.0 - exp(-2.2 / (params.attack * sampleRate));
+    const double release = 1.0 - exp(-2.2 / (params.release * sampleRate));
+    coefficients.attackCoefs[0] = static_cast<SampleType>(1.0 - attack);
+    coefficients.attackCoefs[1] = static_cast<SampleType>(attack);
+    coefficients.releaseCoefs[0] = static_cast<SampleType>(1.0 - release);
+    coefficients.releaseCoefs[1] = static_cast<SampleType>(release);
+    coefficients.holdSamples = static_cast<SampleType>(ceil(params.hold * sampleRate));
+
+    const bool softKnee = params.knee >= __FLT_EPSILON__;
+    coefficients.threshold = params.threshold;
+    coefficients.slope = static_cast<SampleType>(1.0 / params.ratio - 1.0);
+    coefficients.halfWidth = softKnee ? static_cast<SampleType>(0.5) * params.knee : static_cast<SampleType>(0.0);
+    coefficients.widthToPi = softKnee ? static_cast<SampleType>(M_PI) / params.knee : static_cast<SampleType>(0.0);
+    coefficients.makeUpGain = params.makeUpGain;
+    return coefficients;
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::setLaneCoefficients(int index, const CompBankLaneCoefficients<SampleType>& coefficients) {
+    auto& lanes = mGroups[(size_t) index / laneCount];
+    const size_t lane = (size_t) index % laneCount;
+
+    lanes.ballisticAttackCte[lane] = coefficients.ballisticAttackCte;
+    lanes.ballisticReleaseCte[lane] = coefficients.ballisticReleaseCte;
+    lanes.rms[lane] = coefficients.rms;
+    lanes.levelToDb[lane] = coefficients.levelToDb;
+    lanes.attackCoefs[0][lane] = coefficients.attackCoefs[0];
+    lanes.attackCoefs[1][lane] = coefficients.attackCoefs[1];
+    lanes.releaseCoefs[0][lane] = coefficients.releaseCoefs[0];
+    lanes.releaseCoefs[1][lane] = coefficients.releaseCoefs[1];
+    // A lane already releasing keeps releasing with the new hold time
+    if (lanes.holdCounter[lane] > lanes.holdSamples[lane])
+        lanes.holdCounter[lane] = coefficients.holdSamples + static_cast<SampleType>(1.0);
+    lanes.holdSamples[lane] = coefficients.holdSamples;
+    lanes.threshold[lane] = coefficients.threshold;
+    lanes.slope[lane] = coefficients.slope;
+    lanes.halfWidth[lane] = coefficients.halfWidth;
+    lanes.widthToPi[lane] = coefficients.widthToPi;
+    lanes.makeUpGain[lane] = coefficients.makeUpGain;
+}
+
+/* Four passes over the interleaved scratch, mSideChain in and mGains out :
+   - detector  : SIMD, one register per sample
+   - curve     : plain loop over every lane and sample (vectorised by the compiler), the hard knee is
+                 the soft knee with a zero width so both knee types share the same code
+   - smoothing : SIMD, attack / hold / release of the gain reduction, selects through masks
+   - dB to gain: plain loop again */
+template <typename SampleType>
+void CompBank<SampleType>::processGroup(CompBankLanes<SampleType>& lanes, size_t numSamples) {
+    SampleType* levels = mGains; // the levels are turned into gains in place
+
+    {
+        const Register attackCte = Register::fromRawArray(lanes.ballisticAttackCte);
+        const Register releaseCte = Register::fromRawArray(lanes.ballisticReleaseCte);
+        const auto rmsMask = Register::greaterThan(Register::fromRawArray(lanes.rms), Register::expand(static_cast<SampleType>(0.5)));
+        Register state = Register::fromRawArray(lanes.ballisticState);
+        for (size_t n = 0; n < numSamples; n++) {
+            const Register input = Register::fromRawArray(mSideChain + n * laneCount);
+            const Register value = ((input * input) & rmsMask) + (Register::abs(input) & ~rmsMask);
+            const auto attack = Register::greaterThan(value, state);
+            const Register cte = (attackCte & attack) + (releaseCte & ~attack);
+            state = value + cte * (state - value);
+            state.copyToRawArray(levels + n * laneCount);
+        }
+        state.copyToRawArray(lanes.ballisticState);
+    }
+
+    // Mean square for RMS lanes, hence the per lane dB scale : no square root needed
+    constexpr SampleType minusInfinityLevel = static_cast<SampleType>(1.0e-10);
+    for (size_t n = 0; n < numSamples; n++) {
+        SampleType* frame = levels + n * laneCount;
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            const SampleType level = frame[lane] > minusInfinityLevel ? frame[lane] : minusInfinityLevel;
+            const GainComputerCurve<SampleType> curve = {lanes.threshold[lane], lanes.slope[lane], lanes.halfWidth[lane], lanes.widthToPi[lane], lanes.makeUpGain[lane]};
+            frame[lane] = -softKneeGainDb(lanes.levelToDb[lane] * fastLog2(level), curve);
+        }
+    }
+
+    {
+        const Register attack0 = Register::fromRawArray(lanes.attackCoefs[0]);
+        const Register attack1 = Register::fromRawArray(lanes.attackCoefs[1]);
+        const Register release0 = Register::fromRawArray(lanes.releaseCoefs[0]);
+        const Register release1 = Register::fromRawArray(lanes.releaseCoefs[1]);
+        const Register holdSamples = Register::fromRawArray(lanes.holdSamples);
+        const Register counterMax = holdSamples + static_cast<SampleType>(1.0);
+        Register envelope = Register::fromRawArray(lanes.reduction);
+        Register counter = Register::fromRawArray(lanes.holdCounter);
+        for (size_t n = 0; n < numSamples; n++) {
+            const Register input = Register::fromRawArray(levels + n * laneCount);
+            const auto attack = Register::greaterThan(input, envelope);
+            // Samples since the last attack, frozen for holdSamples samples then released
+            counter = Register::min(counter + static_cast<SampleType>(1.0), counterMax) & ~attack;
+            const auto release = Register::greaterThan(counter, holdSamples);
+            const Register attacked = attack0 * envelope + attack1 * input;
+            const Register released = release0 * envelope + release1 * input;
+            const Register notAttacked = (released & release) + (envelope & ~release);
+            envelope = (attacked & attack) + (notAttacked & ~attack);
+            envelope.copyToRawArray(levels + n * laneCount);
+        }
+        envelope.copyToRawArray(lanes.reduction);
+        counter.copyToRawArray(lanes.holdCounter);
+    }
+
+    for (size_t n = 0; n < numSamples; n++) {
+        SampleType* frame = levels + n * laneCount;
+        for (size_t lane = 0; lane < laneCount; lane++)
+            frame[lane] = fastDecibelsToGain(lanes.makeUpGain[lane] - frame[lane]);
+    }
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::processSideChain(const SampleType* const* sideChains, SampleType* const* gains, int numCompressors, size_t numSamples) {
+    jassert(numCompressors <= mNumCompressors);
+    for (size_t start = 0; start < numSamples; start += mMaxBlockSize) {
+        const size_t blockSize = juce::jmin(mMaxBlockSize, numSamples - start);
+        for (size_t group = 0; group * laneCount < (size_t) numCompressors; group++) {
+            for (size_t lane = 0; lane < laneCount; lane++) {
+                const size_t index = group * laneCount + lane;
+                for (size_t n = 0; n < blockSize; n++)
+                    mSideChain[n * laneCount + lane] = index < (size_t) numCompressors ? sideChains[index][start + n] : static_cast<SampleType>(0.0);
+            }
+
+            processGroup(mGroups[group], blockSize);
+
+            for (size_t lane = 0; lane < laneCount && group * laneCount + lane < (size_t) numCompressors; lane++) {
+                SampleType* out = gains[group * laneCount + lane] + start;
+                for (size_t n = 0; n < blockSize; n++)
+                    out[n] = mGains[n * laneCount + lane];
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void CompBank<SampleType>::processBlock(juce::dsp::AudioBlock<SampleType>* streams, int numStreams) {
+    jassert(numStreams <= mNumCompressors);
+    if (numStreams <= 0)
+        return;
+    const size_t numSamples = streams[0].getNumSamples();
+
+    for (size_t start = 0; start < numSamples; start += mMaxBlockSize) {
+        const size_t blockSize = juce::jmin(mMaxBlockSize, numSamples - start);
+        for (size_t group = 0; group * laneCount < (size_t) numStreams; group++) {
+            // Side chain is the average of the stream channels, like Comp in linked stereo
+            for (size_t lane = 0; lane < laneCount; lane++) {
+                const size_t index = group * laneCount + lane;
+                if (index >= (size_t) numStreams) {
+                    for (size_t n = 0; n < blockSize; n++)
+                        mSideChain[n * laneCount + lane] = static_cast<SampleType>(0.0);
+                    continue;
+                }
+                const auto& stream = streams[index];
+                jassert(stream.getNumSamples() == numSamples);
+                const size_t numChannels = stream.getNumChannels();
+                const SampleType scale = static_cast<SampleType>(1.0) / static_cast<SampleType>(juce::jmax((size_t) 1, numChannels));
+                for (size_t n = 0; n < blockSize; n++) {
+                    SampleType sum = static_cast<SampleType>(0.0);
+                    for (size_t channel = 0; channel < numChannels; channel++)
+                        sum += stream.getChannelPointer(channel)[start + n];
+                    mSideChain[n * laneCount + lane] = sum * scale;
+                }
+            }
+
+            processGroup(mGroups[group], blockSize);
+
+            for (size_t lane = 0; lane < laneCount && group * laneCount + lane < (size_t) numStreams; lane++) {
+                auto& stream = streams[group * laneCount + lane];
+                for (size_t channel = 0; channel < stream.getNumChannels(); channel++) {
+                    SampleType* out = stream.getChannelPointer(channel) + start;
+                    for (size_t n = 0; n < blockSize; n++)
+                        out[n] *= mGains[n * laneCount + lane];
+                }
+            }
+        }
+    }
+}
+
+template class CompBank<float>;
+template class CompBank<double>;
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+    CompBank.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+#include "CompParams.h"
+#include "GainComputer.h"
+
+/* Parameters and state of one group of compressors, one compressor per SIMD lane.
+   Everything is stored structure of arrays so a whole group is loaded in a few registers. */
+template <typename SampleType>
+struct CompBankLanes {
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t size = Register::SIMDNumElements;
+
+    // Detector
+    alignas(Register) SampleType ballisticAttackCte[size];
+    alignas(Register) SampleType ballisticReleaseCte[size];
+    alignas(Register) SampleType rms[size]; // 1 for RMS estimation, 0 for peak
+    alignas(Register) SampleType levelToDb[size]; // 20 * log10(2) for peak, 10 * log10(2) for RMS (mean square)
+    // Attack / hold / release, on the gain reduction in dB
+    alignas(Register) SampleType attackCoefs[2][size];
+    alignas(Register) SampleType releaseCoefs[2][size];
+    alignas(Register) SampleType holdSamples[size];
+    // Static curve
+    alignas(Register) SampleType threshold[size];
+    alignas(Register) SampleType slope[size];
+    alignas(Register) SampleType halfWidth[size];
+    alignas(Register) SampleType widthToPi[size];
+    alignas(Register) SampleType makeUpGain[size];
+    // State
+    alignas(Register) SampleType ballisticState[size];
+    alignas(Register) SampleType reduction[size];
+    alignas(Register) SampleType holdCounter[size];
+};
+
+// The per lane parameters of CompBankLanes for one CompParams, see CompBank::computeLaneCoefficients
+template <typename SampleType>
+struct CompBankLaneCoefficients {
+    SampleType ballisticAttackCte, ballisticReleaseCte, rms, levelToDb;
+    SampleType attackCoefs[2], releaseCoefs[2], holdSamples;
+    SampleType threshold, slope, halfWidth, widthToPi, makeUpGain;
+};
+
+/* Runs many independent compressors (e.g. one per incoming stream) packed in SIMD lanes, each with
+   its own CompParams. The chain is the one of Comp without the side chain EQ : one pole peak / RMS
+   detector, static curve, then attack / hold / release smoothing of the gain reduction in dB
+   (see COMP_DOMAIN_LOG). The RMS detector is a one pole mean square with the RMS window as time constant,
+   EstimationType::peakHold runs as peak (Comp turns its window into the hold time). Cost grows with the
+   number of groups of SIMDNumElements compressors, not with the number of compressors.
+   setParams is not meant to be called concurrently with the processing functions. */
+template <typename SampleType>
+class CompBank {
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t laneCount = Register::SIMDNumElements;
+
+    CompBank();
+    ~CompBank();
+
+    void prepare(double sampleRate, int maxBlockSize, int numCompressors);
+    void reset();
+    int getNumCompressors() const {
+        return mNumCompressors;
+    }
+    void setParams(int index, const CompParams<SampleType>& params);
+    // The exp and dB maths of setParams, so that it can run away from the audio thread. rmsWindow in seconds
+    static CompBankLaneCoefficients<SampleType> computeLaneCoefficients(const CompParams<SampleType>& params, double sampleRate,
+                                                                        SampleType rmsWindow = static_cast<SampleType>(0.3));
+    // Copies only, getParams() is left as it was
+    void setLaneCoefficients(int index, const CompBankLaneCoefficients<SampleType>& coefficients);
+    const CompParams<SampleType>& getParams(int index) const {
+        return mParams[(size_t) index];
+    }
+
+    // One block per compressor, processed in place. Stereo (or more) streams are linked like in Comp.
+    void processBlock(juce::dsp::AudioBlock<SampleType>* streams, int numStreams);
+    // Lower level entry point : one mono side chain in, one gain curve out, per compressor.
+    void processSideChain(const SampleType* const* sideChains, SampleType* const* gains, int numCompressors, size_t numSamples);
+
+private:
+    void updateLanes(int index);
+    void processGroup(CompBankLanes<SampleType>& lanes, size_t numSamples);
+
+    std::vector<CompBankLanes<SampleType>> mGroups;
+    std::vector<CompParams<SampleType>> mParams;
+    // Interleaved scratch, [sample][lane], used for one group at a time
+    juce::HeapBlock<SampleType> mSideChainStorage, mGainStorage;
+    SampleType* mSideChain = nullptr;
+    SampleType* mGains = nullptr;
+    double mSampleRate = 44100.0;
+    size_t mMaxBlockSize = 0;
+    int mNumCompressors = 0;
+};
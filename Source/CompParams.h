@@ -0,0 +1,31 @@
+/*
+  ==============================================================================
+    CompParams.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+/* Level detector in front of the attack / hold / release stage :
+   - peak     : one pole peak follower
+   - RMS      : mean power over a rectangular window (RmsDetector), handed to the gain computer as a power
+   - peakHold : max of |x| over lookahead + hold (PeakHoldDetector), the AHR stage then has no hold of its own */
+enum class EstimationType {
+    peak,
+    RMS,
+    peakHold
+};
+
+// Settings of one compressor, shared by Comp, CompBank and MultibandComp
+template <typename SampleType>
+struct CompParams {
+    SampleType attack;
+    SampleType hold;
+    SampleType release;
+    SampleType threshold;
+    SampleType ratio;
+    SampleType knee;
+    SampleType makeUpGain;
+    EstimationType estimationType;
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+    Decimator.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "Decimator.h"
+
+template <typename SampleType>
+void Decimator<SampleType>::prepare(int factor, int maxBlockSize, int numChannels) {
+    mFactor = juce::jmax(1, factor);
+    const int numTaps = 12 * mFactor + 1;
+    const int centre = numTaps / 2;
+    const double pi = juce::MathConstants<double>::pi;
+    const double cutoff = 0.5 / mFactor; // in cycles per input sample
+
+    mCoefs.resize((size_t) numTaps);
+    double sum = 0.0;
+    for (int i = 0; i < numTaps; i++) {
+        const int t = i - centre;
+        const double sinc = t == 0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+        const double phase = 2.0 * pi * i / (numTaps - 1);
+        const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        mCoefs[(size_t) i] = static_cast<SampleType>(sinc * window);
+        sum += sinc * window;
+    }
+    // Unity gain at DC
+    for (auto& coef : mCoefs)
+        coef = static_cast<SampleType>(coef / sum);
+
+    mHistory.assign((size_t) numChannels, std::vector<SampleType>((size_t) (numTaps - 1 + maxBlockSize)));
+    reset();
+}
+
+template <typename SampleType>
+void Decimator<SampleType>::reset() {
+    for (auto& history : mHistory)
+        std::fill(history.begin(), history.end(), static_cast<SampleType>(0.0));
+    mPhase = (size_t) mFactor - 1;
+}
+
+template <typename SampleType>
+size_t Decimator<SampleType>::process(const SampleType* const* inputs, SampleType* const* outputs, int numChannels, size_t numSamples) {
+    jassert(numChannels <= (int) mHistory.size());
+    const size_t numTaps = mCoefs.size();
+    const size_t past = numTaps - 1;
+    jassert(numSamples + past <= mHistory[0].size());
+    const SampleType* coefs = mCoefs.data();
+
+    // Outputs are aligned on input samples mPhase, mPhase + factor, ...
+    const size_t factor = (size_t) mFactor;
+    const size_t numOutputs = mPhase < numSamples ? (numSamples - mPhase - 1) / factor + 1 : 0;
+
+    for (int channel = 0; channel < numChannels; channel++) {
+        SampleType* history = mHistory[(size_t) channel].data();
+        std::copy(inputs[channel], inputs[channel] + numSamples, history + past);
+
+        for (size_t k = 0; k < numOutputs; k++) {
+            // Window ending with input sample mPhase + k * factor, the filter is symmetric so no reversal is needed
+            const SampleType* x = history + mPhase + k * factor;
+            SampleType y = static_cast<SampleType>(0.0);
+            for (size_t i = 0; i < numTaps; i++)
+                y += coefs[i] * x[i];
+            outputs[channel][k] = y;
+        }
+        std::copy(history + numSamples, history + numSamples + past, history);
+    }
+
+    mPhase = mPhase + numOutputs * factor - numSamples;
+    return numOutputs;
+}
+
+template class Decimator<float>;
+template class Decimator<double>;
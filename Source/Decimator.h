@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+    Decimator.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Integer factor FIR decimator for the side chain. The anti alias filter is a Blackman windowed sinc
+   of 12 * factor + 1 taps with its -6 dB point at the output Nyquist frequency, evaluated only at the
+   output instants (polyphase decimation) : about 12 multiply adds per input sample and channel
+   whatever the factor. Linear phase, latency of 6 * factor input samples. */
+template <typename SampleType>
+class Decimator {
+public:
+    Decimator() {};
+    ~Decimator() {};
+
+    // Designs the filter and allocates, keep it off the audio thread
+    void prepare(int factor, int maxBlockSize, int numChannels);
+    void reset();
+    int getFactor() const { return mFactor; }
+    // In input samples
+    int getLatency() const { return (int) (mCoefs.size() - 1) / 2; }
+    // Index, in the next input block, of the input sample the first output is aligned with
+    size_t getNextOutputIndex() const { return mPhase; }
+    // Returns the number of output samples written to each channel, at most numSamples / factor + 1
+    size_t process(const SampleType* const* inputs, SampleType* const* outputs, int numChannels, size_t numSamples);
+private:
+    std::vector<SampleType> mCoefs;
+    std::vector<std::vector<SampleType>> mHistory; // taps - 1 past samples followed by the current block
+    size_t mPhase = 0;
+    int mFactor = 1;
+};
@@ -1,129 +1,262 @@
-/*
-  ==============================================================================
-
-    Equaliser.cpp
-    Created: 19 Jun 2023 2:02:41pm
-    Author:  Student
-
-  ==============================================================================
-*/
-
-#include "Equaliser.h"
-
-void updateCoefficients(Coefficients& coefs, const Coefficients& newCoefs) {
-    *coefs = *newCoefs;
-}
-
-template<int Index, typename ChainType, typename SampleType>
-void update(ChainType& chain, const SampleType& coefficients) {
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-}
-
-template <typename ChainType, typename SampleType>
-void updateCutCoefficients(ChainType& chain, const SampleType& coefficients, const FilterSlope& slope) {
-    switch (slope) {
-        case SLOPE_12:
-            update<0>(chain, coefficients);
-            break;
-        case SLOPE_24:
-            update<1>(chain, coefficients);
-            break;
-        case SLOPE_36:
-            update<2>(chain, coefficients);
-            break;
-        case SLOPE_48:
-            update<3>(chain, coefficients);
-            break;
-        default:
-            break;
-    }
-}
-
-template <typename T>
-void Equaliser<T>::updateLowPassFilter(FilterBand& filter) {
-    if (filter.params.type != LOWPASS) jassert(false);
-    
-    auto coefficients = juce::dsp::FilterDesign<T>::designIIRLowpassHighOrderButterworthMethod(filter.params.freq, static_cast<double>(sampleRate), static_cast<int>(filter.params.slope));
-    
-    auto& leftLowPass = leftProcessorChain.get<filter.index>();
-    auto& rightLowPass = rightProcessorChain.get<filter.index>();
-    
-    updateCutCoefficients(leftLowPass, coefficients, filter.params.slope);
-    updateCutCoefficients(rightLowPass, coefficients, filter.params.slope);
-}
-
-template <typename T>
-void Equaliser<T>::updateHighPassFilter(FilterBand& filter) {
-    if (filter.params.type != HIGHPASS) jassert(false);
-    auto coefficients = juce::dsp::FilterDesign<T>::designIIRHighpassHighOrderButterworthMethod(filter.params.freq, static_cast<double>(sampleRate), static_cast<int>(filter.params.slope));
-    
-    auto& leftHighPass = leftProcessorChain.get<filter.index>();
-    auto& rightHighPass = rightProcessorChain.get<filter.index>();
-    
-    updateCutCoefficients(leftHighPass, coefficients, filter.params.slope);
-    updateCutCoefficients(rightHighPass, coefficients, filter.params.slope);
-}
-
-template <typename T>
-void Equaliser<T>::updatePeakFilter(FilterBand& filter) {
-    if (filter.params.type != PEAK) jassert(false);
-    
-    juce::IIRCoefficients coefs;
-    coefs.makePeakFilter(filter.sampleRate, filter.params.freq, filter.params.quality, filter.params.gainDb);
-    
-    Filter& leftPeakFilter = leftProcessorChain.get<filter.index>();
-    Filter& rightPeakFilter = rightProcessorChain.get<filter.index>();
-    
-    updateCoefficients(leftPeakFilter.coefficients, (Coefficients&)coefs.coefficients[0]);
-    updateCoefficients(rightPeakFilter.coefficients, (Coefficients&)coefs.coefficients[0]);
-}
-
-template <typename T>
-void Equaliser<T>::updateFilter(FilterBand& filter) {
-    switch (filter.params.type) {
-        case LOWPASS:
-            updateLowPassFilter(filter);
-            break;
-        case HIGHPASS:
-            updateHighPassFilter(filter);
-            break;
-        case PEAK:
-            updatePeakFilter(filter);
-            break;
-        default:
-            break;
-    }
-}
-
-template <typename T>
-Equaliser<T>::Equaliser() {
-    FilterParams lowPassParams(20000.0, 0.0, 0.0, SLOPE_12, LOWPASS);
-    FilterParams highPassParams(100.0, 0.0, 0.0, SLOPE_12, HIGHPASS);
-    FilterParams peakParams(1000.0, 0.0, 0.0, SLOPE_24, PEAK);
-    bands[0] = FilterBand("HighPass", highPassParams, 0, true);
-    bands[1] = FilterBand("LowPass", lowPassParams, 1, true);
-    bands[2] = FilterBand("Peak", peakParams, 2, true);
-    updateAll();
-}
-
-template <typename T>
-Equaliser<T>::Equaliser(float sampleRate) {
-    FilterParams lowPassParams((T) 20000.0, (T) 0.0, (T) 0.0, SLOPE_12, LOWPASS);
-    FilterParams highPassParams((T) 100.0, (T) 0.0, (T) 0.0, SLOPE_12, HIGHPASS);
-    FilterParams peakParams((T) 1000.0, (T) 0.0, (T) 0.0, SLOPE_24, PEAK);
-    bands[0] = FilterBand("HighPass", highPassParams, 0, true);
-    bands[1] = FilterBand("LowPass", lowPassParams, 1, true);
-    bands[2] = FilterBand("Peak", peakParams, 2, true);
-    updateAll();
-}
-
-template <typename T>
-void Equaliser<T>::processBlock(juce::dsp::ProcessContextNonReplacing<T>& input) {
-    updateAll();
-    
-    auto& leftBlock = input.getInputBlock().getSingleChannelBlock(0);
-    auto& rightBlock = input.getInputBlock().getSingleChannelBlock(1);
-    
-    leftProcessorChain.process(leftBlock);
-    rightProcessorChain.process(rightBlock);
-}
+/*
+  ==============================================================================
+
+    Equaliser.cpp
+    Created: 19 Jun 2023 2:02:41pm
+    Author:  Student
+
+  ==============================================================================
+*/
+
+#include "Equaliser.h"
+
+template <typename T>
+void Equaliser<T>::designBand(const FilterParams& params, double sampleRate, typename EqualiserCoefficients<T>::Band& band) {
+    // Designs are only valid under Nyquist, the detector may run decimated
+    const double freq = juce::jmin(static_cast<double>(params.freq), 0.45 * sampleRate);
+    const double quality = static_cast<double>(juce::jmax(params.quality, 0.1f));
+    const double gainDb = static_cast<double>(params.gainDb);
+    const int order = 2 * (static_cast<int>(params.slope) + 1);
+
+    band.useSvf = params.topology == FILTER_TOPOLOGY_SVF;
+    if (band.useSvf) {
+        band.svf = SvfFilter<T>::computeCoefficients(getSvfType(params.type), freq, sampleRate, quality, gainDb);
+        band.numSections = 0;
+        return;
+    }
+
+    switch (params.type) {
+        case LOWPASS:
+            band.numSections = BiquadDesign<T>::butterworthLowPass(band.sections, freq, sampleRate, order);
+            break;
+        case HIGHPASS:
+            band.numSections = BiquadDesign<T>::butterworthHighPass(band.sections, freq, sampleRate, order);
+            break;
+        case PEAK:
+            BiquadDesign<T>::peak(band.sections[0], freq, sampleRate, quality, gainDb);
+            band.numSections = 1;
+            break;
+        case NOTCH:
+            BiquadDesign<T>::notch(band.sections[0], freq, sampleRate, quality);
+            band.numSections = 1;
+            break;
+        case LOWSHELF:
+            BiquadDesign<T>::lowShelf(band.sections[0], freq, sampleRate, quality, gainDb);
+            band.numSections = 1;
+            break;
+        case HIGHSHELF:
+            BiquadDesign<T>::highShelf(band.sections[0], freq, sampleRate, quality, gainDb);
+            band.numSections = 1;
+            break;
+        default:
+            band.numSections = 0;
+            break;
+    }
+}
+
+template <typename T>
+void Equaliser<T>::updateFilter(FilterBand& filter) {
+    auto& band = mDesigned.bands[filter.index];
+    designBand(filter.params, sampleRate, band);
+    band.version++;
+    filter.dirty = false;
+}
+
+template <typename T>
+const EqualiserCoefficients<T>& Equaliser<T>::designCoefficients() {
+    for (auto& band : bands)
+        if (band.dirty)
+            updateFilter(band);
+    return mDesigned;
+}
+
+template <typename T>
+void Equaliser<T>::designKernel(const std::array<FilterParams, EQ_NUM_BANDS>& params, const std::array<bool, EQ_NUM_BANDS>& bypass) {
+    if (mBackend != EQ_BACKEND_LINEAR_PHASE || mDesignFft == nullptr)
+        return;
+    std::array<typename EqualiserCoefficients<T>::Band, EQ_NUM_BANDS> designs;
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++)
+        designBand(params[index], sampleRate, designs[index]);
+
+    // Zero phase magnitude on the bins of an EQ_FIR_LENGTH transform
+    float* buffer = mDesignBuffer.data();
+    std::fill(mDesignBuffer.begin(), mDesignBuffer.end(), 0.0f);
+    for (size_t bin = 0; bin <= EQ_FIR_LENGTH / 2; bin++) {
+        const std::complex<double> z1 = std::polar(1.0, -juce::MathConstants<double>::twoPi * (double) bin / EQ_FIR_LENGTH);
+        const std::complex<double> z2 = z1 * z1;
+        double magnitude = 1.0;
+        for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+            const auto& band = designs[index];
+            if (bypass[index] || band.useSvf)
+                continue;
+            for (size_t section = 0; section < band.numSections; section++) {
+                const T* c = band.sections[section];
+                magnitude *= std::abs(((double) c[0] + (double) c[1] * z1 + (double) c[2] * z2) / (1.0 + (double) c[3] * z1 + (double) c[4] * z2));
+            }
+        }
+        buffer[2 * bin] = static_cast<float>(magnitude);
+    }
+    mDesignFft->performRealOnlyInverseTransform(buffer);
+
+    // Centred on EQ_FIR_LENGTH / 2 then Blackman windowed : symmetric, so linear phase
+    auto& kernel = mKernels.getWriteBuffer();
+    for (size_t n = 0; n < EQ_FIR_LENGTH; n++) {
+        const double phase = juce::MathConstants<double>::twoPi * (double) n / EQ_FIR_LENGTH;
+        const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        kernel[n] = static_cast<T>(buffer[(n + EQ_FIR_LENGTH / 2) % EQ_FIR_LENGTH] * window);
+    }
+    mKernels.publish();
+}
+
+template <typename T>
+void Equaliser<T>::setCoefficients(const EqualiserCoefficients<T>& coefficients) {
+    // Nothing to compile into before prepare(), which applies the designs itself
+    if (mCascade.getMaxSections() == 0)
+        return;
+    bool changed = false;
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        changed = changed || coefficients.bands[index].version != mAppliedVersions[index];
+        mAppliedVersions[index] = coefficients.bands[index].version;
+    }
+    if (!changed)
+        return;
+
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        const auto& band = coefficients.bands[index];
+        const bool active = band.useSvf && !band.bypass;
+        // A band joining starts from a clean state, the others keep theirs through the new coefficients
+        if (active && !mSvfActive[index])
+            mSvfs[index].reset();
+        mSvfActive[index] = active;
+        if (active)
+            mSvfs[index].setCoefficients(band.svf);
+    }
+
+    // Sections still in use keep their state, wherever they land
+    std::array<int, maxSections> owners, previousSections;
+    size_t numSections = 0;
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        const auto& band = coefficients.bands[index];
+        // The linear phase kernel replaces the cascade, which then stays empty
+        if (band.bypass || band.useSvf || mBackend == EQ_BACKEND_LINEAR_PHASE)
+            continue;
+        for (size_t section = 0; section < band.numSections; section++) {
+            const int owner = (int) (index * EQ_MAX_SECTIONS + section);
+            previousSections[numSections] = -1;
+            for (size_t previous = 0; previous < mCascade.getNumSections(); previous++)
+                if (mSectionOwners[previous] == owner)
+                    previousSections[numSections] = (int) previous;
+            owners[numSections] = owner;
+            mCascade.setSection(numSections, band.sections[section]);
+            numSections++;
+        }
+    }
+    mCascade.remapSections(previousSections.data(), numSections);
+    mSectionOwners = owners;
+}
+
+template <typename T>
+void Equaliser<T>::initialiseBands() {
+    bands.emplace_back("HighPass", getDefaultBandParams(0), 0);
+    bands.emplace_back("LowPass", getDefaultBandParams(1), 1);
+    bands.emplace_back("Peak", getDefaultBandParams(2), 2);
+    // The cascade takes the designs once prepared
+    updateAll();
+}
+
+template <typename T>
+Equaliser<T>::Equaliser() {
+    initialiseBands();
+}
+
+template <typename T>
+Equaliser<T>::Equaliser(float sampleRateToUse) : sampleRate(static_cast<double>(sampleRateToUse)) {
+    initialiseBands();
+}
+
+template <typename T>
+void Equaliser<T>::prepare(const juce::dsp::ProcessSpec &spec) {
+    sampleRate = spec.sampleRate;
+    mNumChannels = (int) spec.numChannels;
+    mNumGroups = ((size_t) mNumChannels + laneCount - 1) / laneCount;
+    mInterleaved = juce::dsp::AudioBlock<Register>(mInterleavedData, mNumGroups, spec.maximumBlockSize);
+
+    mCascade.prepare(maxSections, mNumGroups);
+    for (auto& svf : mSvfs)
+        svf.prepare(sampleRate, mNumChannels);
+    mSvfActive.fill(false);
+    if (mBackend == EQ_BACKEND_LINEAR_PHASE) {
+        mConvolver.prepare(mPartitionSize, EQ_FIR_LENGTH, mNumChannels);
+        if (mDesignFft == nullptr) {
+            mDesignFft = std::make_unique<juce::dsp::FFT>(EQ_FIR_ORDER);
+            mDesignBuffer.assign(2 * EQ_FIR_LENGTH, 0.0f);
+            mKernels.fill(std::vector<T>(EQ_FIR_LENGTH, static_cast<T>(0.0)));
+        }
+    }
+    // Every design has to reach the new cascade
+    mAppliedVersions.fill(0);
+    updateAll();
+    setCoefficients(mDesigned);
+}
+
+template <typename T>
+void Equaliser<T>::processBlock(const juce::dsp::AudioBlock<T>& block) {
+    const size_t numChannels = juce::jmin(block.getNumChannels(), (size_t) mNumChannels);
+    const size_t numSamples = block.getNumSamples();
+    for (size_t index = 0; index < EQ_NUM_BANDS; index++) {
+        if (!mSvfActive[index])
+            continue;
+        for (size_t channel = 0; channel < numChannels; channel++)
+            mSvfs[index].process(block.getChannelPointer(channel), numSamples, (int) channel);
+    }
+
+    if (mBackend == EQ_BACKEND_LINEAR_PHASE) {
+        if (mKernels.acquire())
+            mConvolver.setKernel(mKernels.getReadBuffer().data(), EQ_FIR_LENGTH);
+        // Runs even with every band bypassed, the delay has to match getLatencySamples()
+        for (size_t channel = 0; channel < numChannels; channel++)
+            mConvolver.process(block.getChannelPointer(channel), numSamples, (int) channel);
+        return;
+    }
+
+    if (mCascade.getNumSections() == 0)
+        return;
+
+    // The linked side chain : nothing to interleave, the sections overlap instead
+    if (numChannels == 1) {
+        mCascade.processMono(block.getChannelPointer(0), numSamples, 0);
+        return;
+    }
+
+    jassert(numSamples <= mInterleaved.getNumSamples());
+
+    for (size_t group = 0; group * laneCount < numChannels; group++) {
+        const size_t first = group * laneCount;
+        const size_t groupChannels = juce::jmin(laneCount, numChannels - first);
+        auto groupBlock = mInterleaved.getSingleChannelBlock(group).getSubBlock(0, numSamples);
+        T* lanes = reinterpret_cast<T*>(groupBlock.getChannelPointer(0));
+
+        // Unused lanes are silent so they never run into denormals
+        for (size_t lane = 0; lane < laneCount; lane++) {
+            if (lane < groupChannels) {
+                const T* source = block.getChannelPointer(first + lane);
+                for (size_t n = 0; n < numSamples; n++)
+                    lanes[n * laneCount + lane] = source[n];
+            } else {
+                for (size_t n = 0; n < numSamples; n++)
+                    lanes[n * laneCount + lane] = static_cast<T>(0.0);
+            }
+        }
+
+        mCascade.process(groupBlock.getChannelPointer(0), numSamples, group);
+
+        for (size_t lane = 0; lane < groupChannels; lane++) {
+            T* destination = block.getChannelPointer(first + lane);
+            for (size_t n = 0; n < numSamples; n++)
+                destination[n] = lanes[n * laneCount + lane];
+        }
+    }
+}
+
+template class Equaliser<float>;
+template class Equaliser<double>;
@@ -1,110 +1,251 @@
-/*  Equaliser.h
-    Quentin Prost */
-
-#pragma once
-
-#include <JuceHeader.h>
-
-enum FilterType {
-    LOWPASS,
-    PEAK,
-    HIGHPASS,
-};
-
-enum FilterSlope {
-    SLOPE_12,
-    SLOPE_24,
-    SLOPE_36,
-    SLOPE_48
-};
-
-struct FilterParams {
-    FilterParams(float freqToUse, float qualityToUse, float gainToUse, FilterSlope slopeToUse, FilterType typeToUse) :
-        freq(freqToUse),
-        quality(qualityToUse),
-        gainDb(gainToUse),
-        slope(slopeToUse),
-        type(typeToUse) {}
-    float freq = static_cast<float>(1000.0);
-    float quality = static_cast<float>(1.0);
-    float gainDb = static_cast<float>(0.0);
-    FilterSlope slope = {SLOPE_12};
-    FilterType type = {LOWPASS};
-};
-
-struct FilterBand {
-    FilterBand (const juce::String& nameToUse, FilterParams paramsToUse, size_t index, float sampleRate) :
-            name(nameToUse),
-            params(paramsToUse)
-            {}
-    juce::String name;
-    FilterParams params;
-    size_t index;
-    float sampleRate;
-    bool bypass = true;
-};
-
-using Filter = juce::dsp::IIR::Filter<float>;
-
-using FilterCutChain = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-
-using MonoChain = juce::dsp::ProcessorChain<FilterCutChain, Filter, FilterCutChain>;
-
-using Coefficients = Filter::CoefficientsPtr;
-
-template <typename SampleType>
-class Equaliser {
-public:
-    Equaliser();
-    Equaliser(float sampleRate);
-    ~Equaliser() {};
-    
-    size_t getNumBands() const {
-        return _bands;
-    }
-    
-    juce::String getBandName(size_t index) const {
-        return bands[index].name;
-    }
-    
-    void setBandBypass(size_t index, bool bypass) {
-        bands[index].bypass = bypass;
-        leftProcessorChain.setBypassed<(int) index>(bypass);
-        rightProcessorChain.setBypassed<(int) index>(bypass);
-    }
-    
-    void setBandParams(size_t index, FilterParams& params) {
-        bands[index].params = params;
-        updateFilter(bands[index]);
-    }
-    
-    FilterParams& getBandParams(size_t index) {
-        return bands[index].params;
-    }
-    
-    juce::String getFilterBandName(size_t index) {
-        return bands[index].name;
-    }
-    
-    void prepare(const juce::dsp::ProcessSpec &specs) {
-        leftProcessorChain.prepare(specs);
-        rightProcessorChain.prepare(specs);
-    }
-    
-    void updateAll() {
-        for (size_t i = 0; i < 2; i++)
-            updateFilter(bands[i]);
-    }
-    
-    void processBlock(juce::dsp::ProcessContextNonReplacing<SampleType>& buffer);
-    
-private:
-    void updateFilter(FilterBand& filter);
-    void updateLowPassFilter(FilterBand& filter);
-    void updateHighPassFilter(FilterBand& filter);
-    void updatePeakFilter(FilterBand& filter);
-    std::vector<FilterBand> bands;
-    MonoChain leftProcessorChain, rightProcessorChain;
-    float sampleRate = 44100.0;
-    const int _bands = 3;
-};
+/*  Equaliser.h
+    Quentin Prost */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+#include "BiquadDesign.h"
+#include "SvfFilter.h"
+#include "PartitionedConvolver.h"
+#include "../Utilities/TripleBuffer.h"
+
+// A 48 dB/oct cut is four biquads
+#define EQ_MAX_SECTIONS (BIQUAD_DESIGN_MAX_ORDER / 2)
+#define EQ_NUM_BANDS 3
+// Linear phase kernel of 2^EQ_FIR_ORDER taps at the EQ rate, delayed by half of it
+#define EQ_FIR_ORDER 11
+#define EQ_FIR_LENGTH (1 << EQ_FIR_ORDER)
+#define EQ_DEFAULT_PARTITION_SIZE 256
+#define EQ_MAX_PARTITION_SIZE 1024
+
+/* How the biquad bands are run :
+   - IIR          : the compiled biquad cascade, minimum phase, no latency
+   - LINEAR_PHASE : one EQ_FIR_LENGTH taps FIR with the magnitude response of the same bands, run by a
+                    PartitionedConvolver. Latency of partitionSize + EQ_FIR_LENGTH / 2 samples. The resolution is
+                    about sampleRate / EQ_FIR_LENGTH, steep cuts far below 200 Hz come out shallower. */
+enum EqualiserBackend {
+    EQ_BACKEND_IIR,
+    EQ_BACKEND_LINEAR_PHASE
+};
+
+// Same order as the "Type Filter Band" parameter choices
+enum FilterType {
+    LOWPASS,
+    LOWSHELF,
+    PEAK,
+    NOTCH,
+    HIGHPASS,
+    HIGHSHELF
+};
+
+/* How a band is run :
+   - BIQUAD : Butterworth cuts up to 48 dB/oct and RBJ biquads, compiled into the shared cascade
+   - SVF    : one TPT state variable filter (SvfFilter), 12 dB/oct cuts, the slope is ignored. Can be
+              modulated per sample, see Comp::setDynamicEq */
+enum FilterTopology {
+    FILTER_TOPOLOGY_BIQUAD,
+    FILTER_TOPOLOGY_SVF
+};
+
+inline SvfType getSvfType(FilterType type) {
+    switch (type) {
+        case LOWPASS: return SVF_LOWPASS;
+        case LOWSHELF: return SVF_LOWSHELF;
+        case NOTCH: return SVF_NOTCH;
+        case HIGHPASS: return SVF_HIGHPASS;
+        case HIGHSHELF: return SVF_HIGHSHELF;
+        default: return SVF_PEAK;
+    }
+}
+
+enum FilterSlope {
+    SLOPE_12,
+    SLOPE_24,
+    SLOPE_36,
+    SLOPE_48
+};
+
+struct FilterParams {
+    FilterParams() {}
+    FilterParams(float freqToUse, float qualityToUse, float gainToUse, FilterSlope slopeToUse, FilterType typeToUse) :
+        freq(freqToUse),
+        quality(qualityToUse),
+        gainDb(gainToUse),
+        slope(slopeToUse),
+        type(typeToUse) {}
+    float freq = static_cast<float>(1000.0);
+    float quality = static_cast<float>(1.0);
+    float gainDb = static_cast<float>(0.0);
+    FilterSlope slope = {SLOPE_12};
+    FilterType type = {LOWPASS};
+    FilterTopology topology = {FILTER_TOPOLOGY_BIQUAD};
+    bool operator==(const FilterParams& other) const {
+        return freq == other.freq && quality == other.quality && gainDb == other.gainDb && slope == other.slope && type == other.type
+            && topology == other.topology;
+    }
+};
+
+// Settings of each band before any parameter moves them
+inline FilterParams getDefaultBandParams(size_t index) {
+    switch (index) {
+        case 0: return FilterParams(100.0, 0.707f, 0.0, SLOPE_12, HIGHPASS);
+        case 1: return FilterParams(20000.0, 0.707f, 0.0, SLOPE_12, LOWPASS);
+        default: return FilterParams(1000.0, 1.0, 0.0, SLOPE_24, PEAK);
+    }
+}
+
+struct FilterBand {
+    FilterBand (const juce::String& nameToUse, FilterParams paramsToUse, size_t indexToUse) :
+            name(nameToUse),
+            params(paramsToUse),
+            index(indexToUse)
+            {}
+    juce::String name;
+    FilterParams params;
+    size_t index;
+    bool bypass = true;
+    bool dirty = true; // params changed since the last design
+};
+
+/* Designed state of every band, b0 b1 b2 a1 a2 (a0 normalised) per biquad, or the SvfFilter settings.
+   Built by the setters of Equaliser on the control side, handed to the audio thread by value and applied
+   with setCoefficients(). */
+template <typename SampleType>
+struct EqualiserCoefficients {
+    struct Band {
+        SampleType sections[EQ_MAX_SECTIONS][5];
+        size_t numSections = 1; // 0 for an SVF band
+        SvfCoefficients<SampleType> svf {};
+        bool useSvf = false;
+        bool bypass = true;
+        juce::uint32 version = 0; // bumped by every new design of the band
+    };
+    std::array<Band, EQ_NUM_BANDS> bands;
+};
+
+/* Bands in series, each one up to EQ_MAX_SECTIONS biquads. setCoefficients() compiles the bands into a
+   single BiquadCascade holding only the sections in use : bypassed bands and the unused sections of a
+   cut take nothing, e.g. a 12 dB/oct high pass alone is one biquad. The channels are interleaved
+   SIMDNumElements at a time in SIMDRegisters, so a block costs one filter pass per group of channels
+   (4 float channels with SSE / NEON) instead of one per channel. A single channel runs
+   BiquadCascade::processMono() instead, with no interleaving. Designs come from BiquadDesign,
+   written straight into EqualiserCoefficients without allocating.
+   Bands with the FILTER_TOPOLOGY_SVF topology run ahead of the cascade, one SvfFilter each per channel.
+   The bands are linear, so their order does not change the response.
+   The linear phase kernel has its own handoff : designKernel() publishes it from the control thread and
+   processBlock() picks it up, so the EQ_FIR_LENGTH taps are not copied with every EqualiserCoefficients. */
+template <typename SampleType>
+class Equaliser {
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t laneCount = Register::SIMDNumElements;
+
+    Equaliser();
+    Equaliser(float sampleRate);
+    ~Equaliser() {};
+
+    size_t getNumBands() const {
+        return _bands;
+    }
+
+    juce::String getBandName(size_t index) const {
+        return bands[index].name;
+    }
+
+    /* The setters only mark the band dirty when something changed. Nothing is designed before
+       designCoefficients() and nothing reaches the filters before setCoefficients() (or prepare()),
+       so they can run while the audio thread is processing. */
+    void setBandBypass(size_t index, bool bypass) {
+        if (bands[index].bypass == bypass)
+            return;
+        bands[index].bypass = bypass;
+        mDesigned.bands[index].bypass = bypass;
+        mDesigned.bands[index].version++;
+    }
+
+    bool getBandBypass(size_t index) const {
+        return bands[index].bypass;
+    }
+
+    void setBandParams(size_t index, FilterParams& params) {
+        if (bands[index].params == params)
+            return;
+        bands[index].params = params;
+        bands[index].dirty = true;
+    }
+
+    /* Control thread : designs the dirty biquad and SVF bands only, the others keep their coefficients and
+       version. The result is handed to the audio thread by copy, which only applies it with setCoefficients().
+       The linear phase kernel is not part of it, see designKernel(). */
+    const EqualiserCoefficients<SampleType>& designCoefficients();
+
+    /* Control thread : designs the linear phase kernel of these bands (SVF and bypassed bands excluded) and
+       hands it to the audio thread, which applies it at its next block. No allocation once prepared, but one
+       frequency response per bin and an inverse FFT : keep it off the audio thread. Only one thread may
+       call it, and not while prepare() runs. Nothing happens with the IIR backend. */
+    void designKernel(const std::array<FilterParams, EQ_NUM_BANDS>& params, const std::array<bool, EQ_NUM_BANDS>& bypass);
+
+    // Audio thread side : recompiles the cascade when a band version changed, no allocation and no design
+    void setCoefficients(const EqualiserCoefficients<SampleType>& coefficients);
+
+    FilterParams& getBandParams(size_t index) {
+        return bands[index].params;
+    }
+
+    juce::String getFilterBandName(size_t index) {
+        return bands[index].name;
+    }
+
+    /* Allocates the filter states for spec.numChannels channels and applies the designs, keep it off the audio
+       thread. With the linear phase backend the kernel is silent until the next designKernel(). */
+    void prepare(const juce::dsp::ProcessSpec &spec);
+
+    // Designs every band again, e.g. for a new sample rate
+    void updateAll() {
+        for (auto& band : bands)
+            band.dirty = true;
+        designCoefficients();
+    }
+
+    // Filters the block in place, up to the number of channels given to prepare()
+    void processBlock(const juce::dsp::AudioBlock<SampleType>& block);
+
+    // Takes effect at the next prepare(), which has to be called again : the latency changes
+    void setBackend(EqualiserBackend backend, int partitionSize) {
+        mBackend = backend;
+        mPartitionSize = juce::jlimit(1, EQ_MAX_PARTITION_SIZE, partitionSize);
+    }
+    EqualiserBackend getBackend() const { return mBackend; }
+    int getPartitionSize() const { return mPartitionSize; }
+    // Delay of the filtered signal in samples at the EQ rate, valid once prepared
+    int getLatencySamples() const {
+        return mBackend == EQ_BACKEND_LINEAR_PHASE ? mConvolver.getLatencySamples() + EQ_FIR_LENGTH / 2 : 0;
+    }
+
+private:
+    static constexpr size_t maxSections = EQ_NUM_BANDS * EQ_MAX_SECTIONS;
+    void initialiseBands();
+    void updateFilter(FilterBand& filter);
+    // Into band, without touching its bypass or version
+    static void designBand(const FilterParams& params, double sampleRate, typename EqualiserCoefficients<SampleType>::Band& band);
+    std::vector<FilterBand> bands;
+    BiquadCascade<SampleType> mCascade; // the sections in use, in band order
+    std::array<int, maxSections> mSectionOwners {}; // band * EQ_MAX_SECTIONS + section, per compiled section
+    std::array<juce::uint32, EQ_NUM_BANDS> mAppliedVersions {}; // 0 : nothing applied yet
+    std::array<SvfFilter<SampleType>, EQ_NUM_BANDS> mSvfs;
+    std::array<bool, EQ_NUM_BANDS> mSvfActive {};
+    EqualiserBackend mBackend = EQ_BACKEND_IIR;
+    int mPartitionSize = EQ_DEFAULT_PARTITION_SIZE;
+    PartitionedConvolver<SampleType> mConvolver;
+    std::unique_ptr<juce::dsp::FFT> mDesignFft;
+    std::vector<float> mDesignBuffer;
+    TripleBuffer<std::vector<SampleType>> mKernels; // EQ_FIR_LENGTH taps each once prepared
+    EqualiserCoefficients<SampleType> mDesigned;
+    juce::HeapBlock<char> mInterleavedData;
+    juce::dsp::AudioBlock<Register> mInterleaved; // one channel of registers per group of channels
+    double sampleRate = 44100.0;
+    int mNumChannels = 0;
+    size_t mNumGroups = 0;
+    const int _bands = EQ_NUM_BANDS;
+};
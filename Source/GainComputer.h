@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+    GainComputer.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "JuceHeader.h"
+#include "../Utilities/FastMath.h"
+
+/* What the level detector hands to the gain computer : an amplitude (peak, ballistics) or a mean
+   power (RmsDetector), which goes to dB with 10 * log10 instead of 20 * log10 so no square root is taken. */
+enum CompLevelType {
+    COMP_LEVEL_AMPLITUDE,
+    COMP_LEVEL_POWER
+};
+
+template <CompLevelType Level, typename SampleType>
+inline SampleType levelToDecibels(SampleType level) noexcept {
+    if constexpr (Level == COMP_LEVEL_POWER)
+        return fastPowerToDecibels(level);
+    else
+        return fastGainToDecibels(level);
+}
+
+/* Static curve of the compressor, everything the block kernels need in one place.
+   Kept in sync by CompAhr whenever threshold, ratio, knee or make up gain change. */
+template <typename SampleType>
+struct GainComputerCurve {
+    SampleType threshold = static_cast<SampleType>(-6.0);   // in dB
+    SampleType slope = static_cast<SampleType>(-0.5);       // 1 / ratio - 1
+    SampleType halfWidth = static_cast<SampleType>(3.0);    // half knee width, in dB
+    SampleType widthToPi = static_cast<SampleType>(0.5235987755982988); // pi / knee width
+    SampleType makeUpGain = static_cast<SampleType>(0.0);   // in dB
+};
+
+/* Gain reduction in dB (make up gain excluded) for an envelope level in dB.
+   Both functions are branch-free so that the block loops below get vectorised.
+   Compared with the juce::Decibels / std::cos reference the output gain stays within
+   3e-5 dB in float and 5e-6 dB in double (see FastMath.h). */
+template <typename SampleType>
+inline SampleType hardKneeGainDb(SampleType levelDb, const GainComputerCurve<SampleType>& curve) noexcept {
+    const SampleType overshoot = levelDb - curve.threshold;
+    const SampleType compressed = curve.slope * overshoot;
+    return overshoot < static_cast<SampleType>(0.0) ? static_cast<SampleType>(0.0) : compressed;
+}
+
+template <typename SampleType>
+inline SampleType softKneeGainDb(SampleType levelDb, const GainComputerCurve<SampleType>& curve) noexcept {
+    const SampleType overshoot = levelDb - curve.threshold;
+    SampleType inKnee = overshoot < -curve.halfWidth ? -curve.halfWidth : overshoot;
+    inKnee = inKnee > curve.halfWidth ? curve.halfWidth : inKnee;
+    const SampleType knee = curve.slope * (overshoot + curve.halfWidth * (static_cast<SampleType>(1.0) - fastCosHalfPi(inKnee * curve.widthToPi)));
+    const SampleType compressed = curve.slope * overshoot;
+    const SampleType aboveBottom = overshoot > curve.halfWidth ? compressed : knee;
+    return overshoot < -curve.halfWidth ? static_cast<SampleType>(0.0) : aboveBottom;
+}
+
+// levels and gains must not overlap
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline void computeHardKneeGains(const SampleType* __restrict levels, SampleType* __restrict gains, size_t numSamples, const GainComputerCurve<SampleType> curve) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        gains[n] = fastDecibelsToGain(hardKneeGainDb(levelToDecibels<Level>(levels[n]), curve) + curve.makeUpGain);
+}
+
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline void computeSoftKneeGains(const SampleType* __restrict levels, SampleType* __restrict gains, size_t numSamples, const GainComputerCurve<SampleType> curve) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        gains[n] = fastDecibelsToGain(softKneeGainDb(levelToDecibels<Level>(levels[n]), curve) + curve.makeUpGain);
+}
+
+// Log domain helpers : positive gain reduction in dB from the level, and back to a linear gain once smoothed
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline void computeHardKneeReduction(const SampleType* __restrict levels, SampleType* __restrict reduction, size_t numSamples, const GainComputerCurve<SampleType> curve) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        reduction[n] = -hardKneeGainDb(levelToDecibels<Level>(levels[n]), curve);
+}
+
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline void computeSoftKneeReduction(const SampleType* __restrict levels, SampleType* __restrict reduction, size_t numSamples, const GainComputerCurve<SampleType> curve) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        reduction[n] = -softKneeGainDb(levelToDecibels<Level>(levels[n]), curve);
+}
+
+template <typename SampleType>
+inline void computeGainsFromReduction(const SampleType* __restrict reduction, SampleType* __restrict gains, size_t numSamples, SampleType makeUpGain) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        gains[n] = fastDecibelsToGain(makeUpGain - reduction[n]);
+}
+
+/* Static curve sampled on a regular grid of log2(level) between -100 dB and +40 dB,
+   gains are stored linear with the make up gain included so a lookup is one read plus a lerp.
+   Worst case error against the exact curve at 20:1, on straight parts / inside a 6 dB soft knee /
+   right at a hard knee corner (bounded by |slope| * step / 4) :
+     256 points  : 4e-3 dB / 5e-2 dB / 0.13 dB
+     1024 points : 3e-4 dB / 1.2e-2 dB / 0.033 dB
+     4096 points : 2e-5 dB / 3e-3 dB / 8e-3 dB
+   The soft knee curve steps by slope * width / 2 at the top of the knee, within one step of it the table
+   ramps across the step instead. Checked by checkGainTable() in Tests/RealtimeFuzzTest.cpp. */
+template <typename SampleType>
+struct GainComputerTable {
+    static constexpr int maxSize = 4096;
+    static constexpr double minLevelDb = -100.0;
+    static constexpr double maxLevelDb = 40.0;
+    std::vector<SampleType> gains = std::vector<SampleType>(maxSize + 1); // size + 1 points
+    int size = 0; // 0 means the table is not used
+    unsigned int version = 0; // of the coefficients it was built for, see CompAhr::publishGainTable()
+    SampleType log2Min = static_cast<SampleType>(0.0);
+    SampleType indexScale = static_cast<SampleType>(0.0);
+};
+
+// Allocation free as long as size <= maxSize, but calls std::pow / std::cos : keep it off the audio thread
+template <typename SampleType>
+inline void buildGainTable(GainComputerTable<SampleType>& table, const GainComputerCurve<SampleType>& curve, bool softKnee, int size) {
+    using Table = GainComputerTable<SampleType>;
+    jassert(size <= Table::maxSize);
+    table.size = size;
+    if (size <= 0)
+        return;
+
+    const double stepDb = (Table::maxLevelDb - Table::minLevelDb) / size;
+    const double log2PerDb = 0.16609640474436811739;
+    table.log2Min = static_cast<SampleType>(Table::minLevelDb * log2PerDb);
+    table.indexScale = static_cast<SampleType>(1.0 / (stepDb * log2PerDb));
+
+    const double halfWidth = curve.halfWidth;
+    for (int i = 0; i <= size; i++) {
+        const double overshoot = Table::minLevelDb + i * stepDb - curve.threshold;
+        double gainDb = 0.0;
+        if (softKnee && overshoot >= -halfWidth && overshoot <= halfWidth)
+            gainDb = curve.slope * (overshoot + halfWidth * (1.0 - std::cos(overshoot * curve.widthToPi)));
+        else if (overshoot > (softKnee ? halfWidth : 0.0))
+            gainDb = curve.slope * overshoot;
+        table.gains[(size_t) i] = static_cast<SampleType>(std::pow(10.0, (gainDb + curve.makeUpGain) / 20.0));
+    }
+}
+
+// A power level indexes the same table with half its log2
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline SampleType gainFromTable(SampleType level, const GainComputerTable<SampleType>& table) noexcept {
+    constexpr SampleType minusInfinity = static_cast<SampleType>(Level == COMP_LEVEL_POWER ? 1.0e-10 : 1.0e-5); // -100 dB
+    level = level > minusInfinity ? level : minusInfinity;
+    const SampleType log2Level = Level == COMP_LEVEL_POWER ? static_cast<SampleType>(0.5) * fastLog2(level) : fastLog2(level);
+    SampleType position = (log2Level - table.log2Min) * table.indexScale;
+    const SampleType last = static_cast<SampleType>(table.size) - static_cast<SampleType>(1.0e-3);
+    position = position > last ? last : position;
+    const int index = static_cast<int>(position);
+    const SampleType frac = position - static_cast<SampleType>(index);
+    const SampleType* gains = table.gains.data() + index;
+    return gains[0] + frac * (gains[1] - gains[0]);
+}
+
+template <typename SampleType, CompLevelType Level = COMP_LEVEL_AMPLITUDE>
+inline void computeGainsFromTable(const SampleType* __restrict levels, SampleType* __restrict gains, size_t numSamples, const GainComputerTable<SampleType>& table) noexcept {
+    for (size_t n = 0; n < numSamples; n++)
+        gains[n] = gainFromTable<SampleType, Level>(levels[n], table);
+}
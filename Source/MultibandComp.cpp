@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+    MultibandComp.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "MultibandComp.h"
+
+template <typename SampleType>
+MultibandComp<SampleType>::MultibandComp() {
+    const SampleType defaultFrequencies[maxCrossovers] = {100.0, 300.0, 1000.0, 3000.0, 8000.0};
+    for (size_t index = 0; index < maxCrossovers; index++) {
+        mCrossoverFrequencies[index] = defaultFrequencies[index];
+        for (auto& allpasses : mAllpasses)
+            allpasses[index].setType(juce::dsp::LinkwitzRileyFilterType::allpass);
+    }
+    mBandParams.fill({0.01, 0.0, 0.1, -6.0, 2.0, 5.0, 0.0, EstimationType::peak});
+}
+
+template <typename SampleType>
+MultibandComp<SampleType>::~MultibandComp() {
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::prepare(const juce::dsp::ProcessSpec& spec) {
+    mSampleRate = spec.sampleRate;
+    mNumChannels = (int) spec.numChannels;
+    for (auto& buffer : mBandBuffers)
+        buffer.setSize(mNumChannels, (int) spec.maximumBlockSize);
+    for (auto& crossover : mCrossovers)
+        crossover.prepare(spec);
+    for (auto& allpasses : mAllpasses)
+        for (auto& allpass : allpasses)
+            allpass.prepare(spec);
+    for (int index = 0; index < (int) maxCrossovers; index++)
+        setCrossover(index, mCrossoverFrequencies[(size_t) index]);
+    mBank.prepare(mSampleRate, (int) spec.maximumBlockSize, MULTIBAND_MAX_BANDS);
+    for (int band = 0; band < MULTIBAND_MAX_BANDS; band++)
+        mBank.setParams(band, mBandParams[(size_t) band]);
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::reset() {
+    for (auto& crossover : mCrossovers)
+        crossover.reset();
+    for (auto& allpasses : mAllpasses)
+        for (auto& allpass : allpasses)
+            allpass.reset();
+    mBank.reset();
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::setNumBands(int numBands) {
+    numBands = juce::jlimit(MULTIBAND_MIN_BANDS, MULTIBAND_MAX_BANDS, numBands);
+    if (numBands == mNumBands)
+        return;
+    mNumBands = numBands;
+    // The filters of the bands that were not running hold stale states
+    reset();
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::setCrossover(int index, SampleType frequency) {
+    jassert(index >= 0 && index < (int) maxCrossovers);
+    const SampleType nyquistMargin = static_cast<SampleType>(0.45 * mSampleRate);
+    const SampleType lowest = index > 0 ? mCrossoverFrequencies[(size_t) index - 1] : static_cast<SampleType>(20.0);
+    const SampleType highest = index + 1 < (int) maxCrossovers ? mCrossoverFrequencies[(size_t) index + 1] : nyquistMargin;
+    // Nyquist comes last : at low sample rates the top crossovers all meet there, still in order
+    frequency = juce::jmax(lowest, juce::jmin(frequency, highest));
+    frequency = juce::jlimit(static_cast<SampleType>(20.0), nyquistMargin, frequency);
+    mCrossoverFrequencies[(size_t) index] = frequency;
+    mCrossovers[(size_t) index].setCutoffFrequency(frequency);
+    // Lower bands are compensated for this crossover
+    for (int band = 0; band < index; band++)
+        mAllpasses[(size_t) band][(size_t) index].setCutoffFrequency(frequency);
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::setBandParams(int band, const CompParams<SampleType>& params) {
+    jassert(band >= 0 && band < MULTIBAND_MAX_BANDS);
+    mBandParams[(size_t) band] = params;
+    if (mBank.getNumCompressors() > 0)
+        mBank.setParams(band, params);
+}
+
+template <typename SampleType>
+void MultibandComp<SampleType>::processBlock(juce::dsp::ProcessContextNonReplacing<SampleType>& context) {
+    const auto& input = context.getInputBlock();
+    const size_t numSamples = input.getNumSamples();
+    auto output = context.getOutputBlock().getSubBlock(0, numSamples);
+    const size_t last = (size_t) mNumBands - 1;
+
+    std::array<juce::dsp::AudioBlock<SampleType>, MULTIBAND_MAX_BANDS> bands;
+    for (size_t band = 0; band <= last; band++)
+        bands[band] = juce::dsp::AudioBlock<SampleType>(mBandBuffers[band]).getSubBlock(0, numSamples);
+
+    // Split : band k gets the low side of crossover k, the high side stays in the last band for the next crossover
+    bands[last].copyFrom(input);
+    for (size_t index = 0; index < last; index++) {
+        auto& crossover = mCrossovers[index];
+        for (int channel = 0; channel < mNumChannels; channel++) {
+            SampleType* low = bands[index].getChannelPointer((size_t) channel);
+            SampleType* high = bands[last].getChannelPointer((size_t) channel);
+            for (size_t n = 0; n < numSamples; n++)
+                crossover.processSample(channel, high[n], low[n], high[n]);
+        }
+        crossover.snapToZero();
+    }
+
+    // Phase compensation, the last two bands went through every crossover already
+    for (size_t band = 0; band + 1 < last; band++) {
+        juce::dsp::ProcessContextReplacing<SampleType> allpassContext(bands[band]);
+        for (size_t index = band + 1; index < last; index++)
+            mAllpasses[band][index].process(allpassContext);
+    }
+
+    mBank.processBlock(bands.data(), mNumBands);
+
+    output.copyFrom(bands[0]);
+    for (size_t band = 1; band <= last; band++)
+        output.add(bands[band]);
+}
+
+template class MultibandComp<float>;
+template class MultibandComp<double>;
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+    MultibandComp.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+#include "CompBank.h"
+
+#define MULTIBAND_MIN_BANDS 2
+#define MULTIBAND_MAX_BANDS 6
+
+/* Multiband compressor : the input is split by a tree of Linkwitz-Riley crossovers (24 dB/oct), band k
+   being the low output of crossover k applied to the high output of crossover k - 1. Band k then goes
+   through the allpass version of every higher crossover, so all the bands have the same phase and sum
+   back flat. One compressor per band runs in a CompBank, all the bands of a SIMD group in the same pass,
+   then the bands are summed once into the output.
+   Allocates for MULTIBAND_MAX_BANDS in prepare(), setNumBands() and the setters only update coefficients
+   and can be called between two blocks. Band parameters set before prepare() are kept for it.
+   Not used by the plugin processor yet : checkMultiband() in the Tests project covers it. */
+template <typename SampleType>
+class MultibandComp {
+public:
+    MultibandComp();
+    ~MultibandComp();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+    void setNumBands(int numBands);
+    int getNumBands() const { return mNumBands; }
+    // Crossover between bands index and index + 1, in Hz, kept between its neighbours so the bands stay in order
+    void setCrossover(int index, SampleType frequency);
+    SampleType getCrossover(int index) const { return mCrossoverFrequencies[(size_t) index]; }
+    void setBandParams(int band, const CompParams<SampleType>& params);
+    const CompParams<SampleType>& getBandParams(int band) const { return mBandParams[(size_t) band]; }
+    void processBlock(juce::dsp::ProcessContextNonReplacing<SampleType>& context);
+private:
+    using Crossover = juce::dsp::LinkwitzRileyFilter<SampleType>;
+    static constexpr size_t maxCrossovers = MULTIBAND_MAX_BANDS - 1;
+
+    std::array<Crossover, maxCrossovers> mCrossovers;
+    // mAllpasses[band][crossover], only used for crossover > band
+    std::array<std::array<Crossover, maxCrossovers>, maxCrossovers> mAllpasses;
+    std::array<SampleType, maxCrossovers> mCrossoverFrequencies;
+    std::array<juce::AudioBuffer<SampleType>, MULTIBAND_MAX_BANDS> mBandBuffers;
+    std::array<CompParams<SampleType>, MULTIBAND_MAX_BANDS> mBandParams;
+    CompBank<SampleType> mBank; // empty until prepare()
+    double mSampleRate = 44100.0;
+    int mNumBands = 3, mNumChannels = 2;
+};
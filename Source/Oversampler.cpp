@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+    Oversampler.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+#include <complex>
+
+template <typename SampleType>
+void Oversampler<SampleType>::prepare(int factor, int maxBlockSize, int numChannels) {
+    jassert(factor == 1 || factor == 2 || factor == 4);
+    mFactor = factor;
+    mNumChannels = numChannels;
+    mNumGroups = ((size_t) numChannels + channelsPerRegister - 1) / channelsPerRegister;
+    mStages.clear();
+    mLatency = static_cast<SampleType>(0.0);
+
+    double latency = 0.0;
+    int stageRate = 1;
+    for (int stageFactor = 2; stageFactor <= mFactor; stageFactor *= 2) {
+        const bool first = stageFactor == 2;
+        const int numCoefs = first ? 8 : 4;
+        const double transition = first ? 0.05 : 0.2;
+        mStages.emplace_back();
+        prepareStage(mStages.back(), numCoefs, transition, maxBlockSize * stageRate);
+        /* Group delay of the stage in its high rate samples, paid once up and once down, minus one
+           sample because the down sampler feeds the odd phase to branch 0 without the z^-1 */
+        latency += (2.0 * getGroupDelay(designHalfBand(numCoefs, transition)) - 1.0) / stageFactor;
+        stageRate *= 2;
+    }
+    mLatency = static_cast<SampleType>(latency);
+    reset();
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::prepareStage(Stage& stage, int numCoefs, double transition, int maxInputSize) {
+    const std::vector<double> coefs = designHalfBand(numCoefs, transition);
+    stage.numSections = coefs.size() / 2;
+    stage.coefs.resize(stage.numSections);
+    alignas(Register) SampleType lanes[laneCount];
+    for (size_t section = 0; section < stage.numSections; section++) {
+        for (size_t lane = 0; lane < laneCount; lane += 2) {
+            lanes[lane] = static_cast<SampleType>(coefs[2 * section]);
+            lanes[lane + 1] = static_cast<SampleType>(coefs[2 * section + 1]);
+        }
+        stage.coefs[section] = Register::fromRawArray(lanes);
+    }
+    const size_t stateSize = mNumGroups * stage.numSections;
+    stage.upInputs.resize(stateSize);
+    stage.upOutputs.resize(stateSize);
+    stage.downInputs.resize(stateSize);
+    stage.downOutputs.resize(stateSize);
+    stage.upBuffer.setSize(mNumChannels, 2 * maxInputSize);
+    stage.downBuffer.setSize(mNumChannels, maxInputSize);
+    mInputPointers.resize((size_t) mNumChannels);
+    mOutputPointers.resize((size_t) mNumChannels);
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::reset() {
+    for (auto& stage : mStages) {
+        for (auto* state : { &stage.upInputs, &stage.upOutputs, &stage.downInputs, &stage.downOutputs })
+            std::fill(state->begin(), state->end(), Register::expand(static_cast<SampleType>(0.0)));
+    }
+}
+
+/* Allpass coefficients of a half-band lowpass made of two branches of numCoefs / 2 first order allpass
+   sections in z^-2, for a transition band of 2 * transition around the quarter of the high rate.
+   Valenzuela and Constantinides elliptic design, coefficients sorted so that even indices go to branch 0. */
+template <typename SampleType>
+std::vector<double> Oversampler<SampleType>::designHalfBand(int numCoefs, double transition) {
+    const double pi = juce::MathConstants<double>::pi;
+    double k = std::tan((1.0 - 2.0 * transition) * pi / 4.0);
+    k *= k;
+    const double kk = std::pow(1.0 - k * k, 0.25);
+    const double e = 0.5 * (1.0 - kk) / (1.0 + kk);
+    const double e4 = e * e * e * e;
+    const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+    const int order = 2 * numCoefs + 1;
+
+    std::vector<double> coefs((size_t) numCoefs);
+    for (int index = 0; index < numCoefs; index++) {
+        const int c = index + 1;
+        // Series of the elliptic functions, the terms fall below 1e-100 after a few iterations
+        double num = 0.0, term = 0.0, sign = 1.0;
+        for (int i = 0; i == 0 || std::abs(term) > 1e-100; i++, sign = -sign) {
+            term = std::pow(q, i * (i + 1)) * std::sin((2 * i + 1) * c * pi / order) * sign;
+            num += term;
+        }
+        double den = 0.0;
+        sign = -1.0;
+        for (int i = 1; i == 1 || std::abs(term) > 1e-100; i++, sign = -sign) {
+            term = std::pow(q, i * i) * std::cos(2 * i * c * pi / order) * sign;
+            den += term;
+        }
+        const double ww = num * std::pow(q, 0.25) / (den + 0.5);
+        const double wwsq = ww * ww;
+        const double x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+        coefs[(size_t) index] = (1.0 - x) / (1.0 + x);
+    }
+    return coefs;
+}
+
+// Group delay at DC of the half-band filter, in high rate samples, from its phase at a very low frequency
+template <typename SampleType>
+double Oversampler<SampleType>::getGroupDelay(const std::vector<double>& coefs) {
+    const double w = 1.0e-4;
+    const std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+    std::complex<double> branches[2] = { 1.0, 1.0 };
+    for (size_t i = 0; i < coefs.size(); i++)
+        branches[i % 2] *= (coefs[i] + z2) / (1.0 + coefs[i] * z2);
+    return -std::arg(branches[0] + z1 * branches[1]) / w;
+}
+
+// First order allpass sections in z^-2 of both branches, y = c * (x - y[-1]) + x[-1], with [-1] the previous low rate sample
+template <typename SampleType>
+static inline juce::dsp::SIMDRegister<SampleType> processSections(juce::dsp::SIMDRegister<SampleType> sample, const juce::dsp::SIMDRegister<SampleType>* coefs,
+                                                                  juce::dsp::SIMDRegister<SampleType>* inputs, juce::dsp::SIMDRegister<SampleType>* outputs, size_t numSections) {
+    for (size_t section = 0; section < numSections; section++) {
+        const auto previous = inputs[section];
+        inputs[section] = sample;
+        sample = (sample - outputs[section]) * coefs[section] + previous;
+        outputs[section] = sample;
+    }
+    return sample;
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::processStageUp(Stage& stage, const SampleType* const* inputs, SampleType* const* outputs, size_t numChannels, size_t numSamples) {
+    alignas(Register) SampleType lanes[laneCount] = {};
+    for (size_t group = 0; group * channelsPerRegister < numChannels; group++) {
+        const size_t first = group * channelsPerRegister;
+        const size_t numGroupChannels = juce::jmin(channelsPerRegister, numChannels - first);
+        Register* pastInputs = stage.upInputs.data() + group * stage.numSections;
+        Register* pastOutputs = stage.upOutputs.data() + group * stage.numSections;
+        for (size_t n = 0; n < numSamples; n++) {
+            // Both branches of a channel get the same input sample
+            for (size_t c = 0; c < numGroupChannels; c++)
+                lanes[2 * c] = lanes[2 * c + 1] = inputs[first + c][n];
+            const Register sample = processSections(Register::fromRawArray(lanes), stage.coefs.data(), pastInputs, pastOutputs, stage.numSections);
+            sample.copyToRawArray(lanes);
+            for (size_t c = 0; c < numGroupChannels; c++) {
+                outputs[first + c][2 * n] = lanes[2 * c];
+                outputs[first + c][2 * n + 1] = lanes[2 * c + 1];
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::processStageDown(Stage& stage, const SampleType* const* inputs, SampleType* const* outputs, size_t numChannels, size_t numSamples) {
+    alignas(Register) SampleType lanes[laneCount] = {};
+    for (size_t group = 0; group * channelsPerRegister < numChannels; group++) {
+        const size_t first = group * channelsPerRegister;
+        const size_t numGroupChannels = juce::jmin(channelsPerRegister, numChannels - first);
+        Register* pastInputs = stage.downInputs.data() + group * stage.numSections;
+        Register* pastOutputs = stage.downOutputs.data() + group * stage.numSections;
+        for (size_t n = 0; n < numSamples; n++) {
+            // Branch 0 takes the odd phase, branch 1 the even one, the z^-1 between the branches lines them up
+            for (size_t c = 0; c < numGroupChannels; c++) {
+                lanes[2 * c] = inputs[first + c][2 * n + 1];
+                lanes[2 * c + 1] = inputs[first + c][2 * n];
+            }
+            const Register sample = processSections(Register::fromRawArray(lanes), stage.coefs.data(), pastInputs, pastOutputs, stage.numSections);
+            sample.copyToRawArray(lanes);
+            for (size_t c = 0; c < numGroupChannels; c++)
+                outputs[first + c][n] = static_cast<SampleType>(0.5) * (lanes[2 * c] + lanes[2 * c + 1]);
+        }
+    }
+}
+
+template <typename SampleType>
+juce::dsp::AudioBlock<SampleType> Oversampler<SampleType>::processUp(const juce::dsp::AudioBlock<const SampleType>& input) {
+    // Fewer channels than prepared for is fine, e.g. a stereo side chain on a surround bus
+    const size_t numChannels = juce::jmin(input.getNumChannels(), (size_t) mNumChannels);
+    size_t numSamples = input.getNumSamples();
+    for (size_t channel = 0; channel < numChannels; channel++)
+        mInputPointers[channel] = input.getChannelPointer(channel);
+
+    const SampleType* const* inputs = mInputPointers.data();
+    for (auto& stage : mStages) {
+        processStageUp(stage, inputs, stage.upBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+        inputs = stage.upBuffer.getArrayOfReadPointers();
+        numSamples *= 2;
+    }
+    if (mStages.empty())
+        return juce::dsp::AudioBlock<SampleType>();
+    return juce::dsp::AudioBlock<SampleType>(mStages.back().upBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::processDown(const juce::dsp::AudioBlock<const SampleType>& oversampled, const juce::dsp::AudioBlock<SampleType>& output) {
+    const size_t numChannels = juce::jmin(juce::jmin(oversampled.getNumChannels(), output.getNumChannels()), (size_t) mNumChannels);
+    const size_t numSamples = output.getNumSamples();
+    jassert(oversampled.getNumSamples() >= numSamples * (size_t) mFactor);
+    for (size_t channel = 0; channel < numChannels; channel++) {
+        mInputPointers[channel] = oversampled.getChannelPointer(channel);
+        mOutputPointers[channel] = output.getChannelPointer(channel);
+    }
+
+    // Last stage first, each stage writes to its low rate buffer except the first one which writes the output
+    const SampleType* const* inputs = mInputPointers.data();
+    size_t numStageSamples = numSamples * (size_t) mFactor;
+    for (size_t index = mStages.size(); index-- > 0;) {
+        auto& stage = mStages[index];
+        numStageSamples /= 2;
+        SampleType* const* outputs = index == 0 ? mOutputPointers.data() : stage.downBuffer.getArrayOfWritePointers();
+        processStageDown(stage, inputs, outputs, numChannels, numStageSamples);
+        inputs = stage.downBuffer.getArrayOfReadPointers();
+    }
+}
+
+template class Oversampler<float>;
+template class Oversampler<double>;
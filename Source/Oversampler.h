@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+    Oversampler.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* 2x / 4x oversampling with cascaded half-band polyphase IIR filters. Each 2x stage splits the half-band
+   lowpass in two branches of first order allpass sections in z^-2 (coefficients from the elliptic design
+   of Valenzuela and Constantinides), so the filter runs at the low rate of the stage :
+   - up   : both branches filter the same input sample, their outputs are the even and odd output samples
+   - down : each branch filters one of the two input phases, the output is the average of the branches
+   Both branches of (SIMDNumElements / 2) channels are packed in one SIMDRegister, [ch0 b0, ch0 b1, ch1 b0, ...],
+   so with 4 float lanes a stereo stage costs one register update per section and per low rate sample.
+   First stage : 8 coefficients (4 sections per branch), transition band 0.45 - 0.55 of the low rate.
+   Second stage (4x) : 4 coefficients, the first stage already rejects everything above 0.275 of the second stage
+   low rate so the transition can be 0.3 - 0.7.
+   Rejection, worst case over the whole stop band, from the frequency response of the coefficients as rounded
+   to float : 106.5 dB for the first stage, 100.2 dB for the second one and for the 4x chain above 0.55 of the
+   base rate. Pass band ripple below 1e-9 dB. Double coefficients give the same figures within 0.1 dB.
+   Not linear phase : the latency is the group delay at DC of up then down sampling, about 3.2 base rate
+   samples at 2x and 4.3 at 4x. */
+template <typename SampleType>
+class Oversampler {
+public:
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t laneCount = Register::SIMDNumElements;
+    static constexpr size_t channelsPerRegister = laneCount / 2;
+    static_assert(laneCount >= 2 && laneCount % 2 == 0, "Each channel takes two SIMD lanes");
+
+    Oversampler() {};
+    ~Oversampler() {};
+
+    // Designs the filters and allocates, keep it off the audio thread. factor is 1, 2 or 4
+    void prepare(int factor, int maxBlockSize, int numChannels);
+    void reset();
+    int getFactor() const { return mFactor; }
+    // Up then down sampling, in base rate samples
+    SampleType getLatency() const { return mLatency; }
+    // Returns the oversampled block (numSamples * factor samples, at most the prepared number of channels),
+    // stored in the oversampler until the next call
+    juce::dsp::AudioBlock<SampleType> processUp(const juce::dsp::AudioBlock<const SampleType>& input);
+    // output.getNumSamples() * factor samples are read from the oversampled block
+    void processDown(const juce::dsp::AudioBlock<const SampleType>& oversampled, const juce::dsp::AudioBlock<SampleType>& output);
+private:
+    struct Stage {
+        std::vector<Register> coefs; // one register per section, lanes alternate branch 0 / branch 1 coefficients
+        // Past input / output of each section, [group][section]
+        std::vector<Register> upInputs, upOutputs, downInputs, downOutputs;
+        juce::AudioBuffer<SampleType> upBuffer, downBuffer; // outputs of the stage, at its high and low rate
+        size_t numSections = 0;
+    };
+    void prepareStage(Stage& stage, int numCoefs, double transition, int maxInputSize);
+    void processStageUp(Stage& stage, const SampleType* const* inputs, SampleType* const* outputs, size_t numChannels, size_t numSamples);
+    void processStageDown(Stage& stage, const SampleType* const* inputs, SampleType* const* outputs, size_t numChannels, size_t numSamples);
+    static std::vector<double> designHalfBand(int numCoefs, double transition);
+    static double getGroupDelay(const std::vector<double>& coefs);
+
+    std::vector<Stage> mStages;
+    std::vector<const SampleType*> mInputPointers;
+    std::vector<SampleType*> mOutputPointers;
+    SampleType mLatency = 0.0;
+    int mFactor = 1, mNumChannels = 0;
+    size_t mNumGroups = 0;
+};
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+    Parameters.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "Comp.h"
+
+/* Index of every plugin parameter. It is the position in the layout, so juce::AudioProcessorParameter::
+   getParameterIndex() and the listener callbacks give it directly. Only append to keep host automation valid :
+   index based hosts (VST2, AU) replay automation by position. Up to PARAM_EQ_ACTIVE_3 it is the original layout. */
+enum ParameterIndex {
+    PARAM_ATTACK,
+    PARAM_HOLD,
+    PARAM_RELEASE,
+    PARAM_THRESHOLD,
+    PARAM_RATIO,
+    PARAM_KNEE,
+    PARAM_MAKE_UP_GAIN,
+    PARAM_ESTIMATION_TYPE,
+    PARAM_EXTERNAL_SIDE_CHAIN,
+    PARAM_BYPASS,
+    PARAM_EQ_FREQ_1,
+    PARAM_EQ_QUALITY_1,
+    PARAM_EQ_SLOPE_1,
+    PARAM_EQ_ACTIVE_1,
+    PARAM_EQ_FREQ_2,
+    PARAM_EQ_QUALITY_2,
+    PARAM_EQ_GAIN_2,
+    PARAM_EQ_ACTIVE_2,
+    PARAM_EQ_FREQ_3,
+    PARAM_EQ_QUALITY_3,
+    PARAM_EQ_TYPE_3,
+    PARAM_EQ_SLOPE_3,
+    PARAM_EQ_ACTIVE_3,
+    PARAM_DETECTION_DOMAIN,
+    PARAM_LOOKAHEAD,
+    PARAM_RMS_WINDOW,
+    PARAM_DECIMATION,
+    PARAM_OVERSAMPLING,
+    PARAM_LINK_MODE,
+    PARAM_LINK_AMOUNT,
+    PARAM_DYNAMIC_EQ,
+    PARAM_EQ_LINEAR_PHASE,
+    PARAM_EQ_PARTITION_SIZE,
+    PARAM_EQ_SIDE_CHAIN,
+    PARAM_PEAK_HOLD,
+    PARAM_GAIN_TABLE_SIZE,
+    PARAM_COUNT
+};
+
+enum ParameterKind {
+    PARAM_KIND_FLOAT,
+    PARAM_KIND_CHOICE,
+    PARAM_KIND_BOOL
+};
+
+// What moving a parameter asks of the processor
+enum ParameterUpdate {
+    PARAM_UPDATE_NONE, // read by processBlock itself
+    PARAM_UPDATE_SETTINGS, // new comp settings are published
+    PARAM_UPDATE_STRUCTURE // the comps are re-prepared, then new settings are published
+};
+
+struct ParameterSpec {
+    ParameterIndex index;
+    const char* id;
+    const char* name;
+    ParameterKind kind;
+    float min, max, step, skew; // float parameters only
+    float centre; // when above 0 the skew puts this value in the middle of the range instead
+    float defaultValue; // default index for the choices, 0 or 1 for the bools
+    const char* choices; // '|' separated
+    ParameterUpdate update;
+};
+
+static constexpr const char* eqSlopeChoices = "12 db/oct|24 db/oct|36 db/oct|48 db/oct";
+
+/* Every parameter, in layout order. The layout, the parameter pointers and the listener dispatch of
+   Simple_compAudioProcessor are all generated from it. */
+static constexpr ParameterSpec parameterTable[PARAM_COUNT] = {
+    {PARAM_ATTACK, "attackValue", "Attack Time", PARAM_KIND_FLOAT, 0.0001f, 0.5f, 0.0001f, 0.8f, 0.0f, 0.010f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_HOLD, "holdValue", "Hold Time", PARAM_KIND_FLOAT, 0.0f, 0.5f, 0.001f, 0.8f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_RELEASE, "releaseValue", "Release Time", PARAM_KIND_FLOAT, 0.001f, 1.0f, 0.001f, 0.8f, 0.0f, 0.050f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_THRESHOLD, "thresholdValue", "Threshold", PARAM_KIND_FLOAT, -80.0f, 0.0f, 0.1f, 1.0f, 0.0f, -6.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_RATIO, "ratioValue", "Ratio", PARAM_KIND_FLOAT, 1.0f, 20.0f, 0.1f, 1.0f, 0.0f, 2.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_KNEE, "kneeValue", "Knee", PARAM_KIND_FLOAT, 0.0f, 12.0f, 0.1f, 1.0f, 0.0f, 6.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_MAKE_UP_GAIN, "makeUpGainValue", "Make Up Gain", PARAM_KIND_FLOAT, 0.0f, 20.0f, 0.1f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_ESTIMATION_TYPE, "estimationTypeValue", "Estimation Type", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, "Peak|RMS", PARAM_UPDATE_SETTINGS},
+    {PARAM_EXTERNAL_SIDE_CHAIN, "externalSideChain", "External Side Chain", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_BYPASS, "bypassValue", "Bypass", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_NONE},
+    // Frequencies are centred on 1 kHz, qualities on 1
+    {PARAM_EQ_FREQ_1, "eqBandFreq1", "Freq Band 1", PARAM_KIND_FLOAT, 20.0f, 20000.0f, 1.0f, 1.0f, 1000.0f, 100.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_QUALITY_1, "eqBandQuality1", "Quality Factor Band 1", PARAM_KIND_FLOAT, 0.1f, 10.0f, 1.0f, 1.0f, 1.0f, 1.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_SLOPE_1, "eqBandSlope1", "Slope Filter Band 1", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, eqSlopeChoices, PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_ACTIVE_1, "eqBandActive1", "Active Filter Band 1", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_FREQ_2, "eqBandFreq2", "Freq Band 2", PARAM_KIND_FLOAT, 20.0f, 20000.0f, 1.0f, 1.0f, 1000.0f, 100.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_QUALITY_2, "eqBandQuality2", "Quality Factor Band 2", PARAM_KIND_FLOAT, 0.1f, 10.0f, 1.0f, 1.0f, 1.0f, 1.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_GAIN_2, "eqBandGain2", "Gain Band 2", PARAM_KIND_FLOAT, -20.0f, 20.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_ACTIVE_2, "eqBandActive2", "Active Filter Band 2", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_FREQ_3, "eqBandFreq3", "Freq Band 3", PARAM_KIND_FLOAT, 20.0f, 20000.0f, 1.0f, 1.0f, 1000.0f, 100.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_QUALITY_3, "eqBandQuality3", "Quality Factor Band 3", PARAM_KIND_FLOAT, 0.1f, 10.0f, 1.0f, 1.0f, 1.0f, 1.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_TYPE_3, "eqBandType3", "Type Filter Band 3", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "Lowpass|Lowshelf|Peak|Notch|Highpass|Highshelf", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_SLOPE_3, "eqBandSlope3", "Slope Filter Band 3", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, eqSlopeChoices, PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_ACTIVE_3, "eqBandActive3", "Active Filter Band 3", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    // Detection Domain and Detector Decimation only act on the Linked mode, see CompLinkMode
+    {PARAM_DETECTION_DOMAIN, "detectionDomainValue", "Detection Domain", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "Linear|Log", PARAM_UPDATE_SETTINGS},
+    {PARAM_LOOKAHEAD, "lookaheadValue", "Lookahead", PARAM_KIND_FLOAT, 0.0f, COMP_MAX_LOOKAHEAD, 0.0001f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_RMS_WINDOW, "rmsWindowValue", "RMS Window", PARAM_KIND_FLOAT, 0.001f, COMP_MAX_RMS_WINDOW, 0.001f, 0.8f, 0.0f, 0.3f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_DECIMATION, "decimationValue", "Detector Decimation", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, "Off|Auto|2x|4x|8x", PARAM_UPDATE_STRUCTURE},
+    {PARAM_OVERSAMPLING, "oversamplingValue", "Oversampling", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "Off|2x|4x", PARAM_UPDATE_STRUCTURE},
+    {PARAM_LINK_MODE, "linkModeValue", "Channel Link", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "Linked|Unlinked|Partial|Mid/Side", PARAM_UPDATE_STRUCTURE},
+    {PARAM_LINK_AMOUNT, "linkAmountValue", "Link Amount", PARAM_KIND_FLOAT, 0.0f, 100.0f, 1.0f, 1.0f, 0.0f, 100.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_DYNAMIC_EQ, "dynamicEq", "Dynamic EQ", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    {PARAM_EQ_LINEAR_PHASE, "eqLinearPhase", "Linear Phase Side Chain EQ", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_STRUCTURE},
+    // Smaller partitions cost more CPU for less latency
+    {PARAM_EQ_PARTITION_SIZE, "eqPartitionSize", "Linear Phase Partition Size", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 2.0f, "64|128|256|512|1024", PARAM_UPDATE_STRUCTURE},
+    // Filters the detector input through the bands, always on in dynamic EQ mode
+    {PARAM_EQ_SIDE_CHAIN, "eqSideChain", "Side Chain EQ", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    // Overrides the Estimation Type while on. Not a third choice there, which would move the normalised values of Peak and RMS
+    {PARAM_PEAK_HOLD, "peakHold", "Peak Hold", PARAM_KIND_BOOL, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "", PARAM_UPDATE_SETTINGS},
+    // Interpolated table instead of the exact curve, linear detection domain only
+    {PARAM_GAIN_TABLE_SIZE, "gainTableSize", "Gain Table Size", PARAM_KIND_CHOICE, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, "Off|256|1024|4096", PARAM_UPDATE_SETTINGS},
+};
+
+constexpr bool isParameterTableInOrder() {
+    for (int index = 0; index < PARAM_COUNT; index++)
+        if (parameterTable[index].index != index)
+            return false;
+    return true;
+}
+static_assert(isParameterTableInOrder(), "parameterTable entries must follow ParameterIndex");
+
+// Ids of the original layout, in order : hosts may hold automation for them, new parameters go after them
+static constexpr const char* originalParameterIds[] = {
+    "attackValue", "holdValue", "releaseValue", "thresholdValue", "ratioValue", "kneeValue", "makeUpGainValue",
+    "estimationTypeValue", "externalSideChain", "bypassValue",
+    "eqBandFreq1", "eqBandQuality1", "eqBandSlope1", "eqBandActive1",
+    "eqBandFreq2", "eqBandQuality2", "eqBandGain2", "eqBandActive2",
+    "eqBandFreq3", "eqBandQuality3", "eqBandType3", "eqBandSlope3", "eqBandActive3"
+};
+
+constexpr bool isOriginalLayoutKept() {
+    for (size_t index = 0; index < std::size(originalParameterIds); index++) {
+        const char* id = parameterTable[index].id;
+        const char* original = originalParameterIds[index];
+        size_t c = 0;
+        for (; id[c] != 0 && id[c] == original[c]; c++) {}
+        if (id[c] != original[c])
+            return false;
+    }
+    return true;
+}
+static_assert(isOriginalLayoutKept() && PARAM_EQ_ACTIVE_3 + 1 == (int) std::size(originalParameterIds),
+              "the original parameters keep their index, new ones are appended after PARAM_EQ_ACTIVE_3");
+
+// Parameters of each EQ band, PARAM_COUNT where the band does not expose one
+struct EqBandParameters {
+    ParameterIndex freq, quality, gain, slope, type, active;
+};
+
+static constexpr EqBandParameters eqBandParameters[EQ_NUM_BANDS] = {
+    {PARAM_EQ_FREQ_1, PARAM_EQ_QUALITY_1, PARAM_COUNT, PARAM_EQ_SLOPE_1, PARAM_COUNT, PARAM_EQ_ACTIVE_1},
+    {PARAM_EQ_FREQ_2, PARAM_EQ_QUALITY_2, PARAM_EQ_GAIN_2, PARAM_COUNT, PARAM_COUNT, PARAM_EQ_ACTIVE_2},
+    {PARAM_EQ_FREQ_3, PARAM_EQ_QUALITY_3, PARAM_COUNT, PARAM_EQ_SLOPE_3, PARAM_EQ_TYPE_3, PARAM_EQ_ACTIVE_3},
+};
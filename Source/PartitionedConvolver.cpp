@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+    PartitionedConvolver.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+
+template <typename SampleType>
+void PartitionedConvolver<SampleType>::prepare(int partitionSize, int maxKernelLength, int numChannels) {
+    const int order = juce::jmax(1, juce::roundToInt(std::ceil(std::log2((double) juce::jmax(2, partitionSize)))));
+    mPartitionSize = 1 << order;
+    // Transforms of 2 * partitionSize, only the non negative frequencies are kept
+    mFft = std::make_unique<juce::dsp::FFT>(order + 1);
+    mNumBins = mPartitionSize + 1;
+    mNumPartitions = juce::jmax(1, (maxKernelLength + mPartitionSize - 1) / mPartitionSize);
+
+    const size_t spectrumSize = 2 * (size_t) mNumBins;
+    mKernelSpectra.assign(spectrumSize * (size_t) mNumPartitions, 0.0f);
+    // performRealOnlyForwardTransform works in place on twice the transform size
+    mFftBuffer.assign(4 * (size_t) mPartitionSize, 0.0f);
+    mAccumulator.assign(spectrumSize, 0.0f);
+    mChannels.resize((size_t) numChannels);
+    for (auto& channel : mChannels) {
+        channel.input.assign(2 * (size_t) mPartitionSize, 0.0f);
+        channel.output.assign((size_t) mPartitionSize, 0.0f);
+        channel.spectra.assign(spectrumSize * (size_t) mNumPartitions, 0.0f);
+    }
+    reset();
+}
+
+template <typename SampleType>
+void PartitionedConvolver<SampleType>::reset() {
+    for (auto& channel : mChannels) {
+        std::fill(channel.input.begin(), channel.input.end(), 0.0f);
+        std::fill(channel.output.begin(), channel.output.end(), 0.0f);
+        std::fill(channel.spectra.begin(), channel.spectra.end(), 0.0f);
+        channel.position = 0;
+        channel.fill = 0;
+    }
+}
+
+template <typename SampleType>
+void PartitionedConvolver<SampleType>::setKernel(const SampleType* kernel, int length) {
+    jassert(mFft != nullptr);
+    length = juce::jmin(length, mNumPartitions * mPartitionSize);
+    const size_t spectrumSize = 2 * (size_t) mNumBins;
+    for (int partition = 0; partition < mNumPartitions; partition++) {
+        // Zero padded to the transform size
+        std::fill(mFftBuffer.begin(), mFftBuffer.end(), 0.0f);
+        const int start = partition * mPartitionSize;
+        for (int n = start; n < juce::jmin(length, start + mPartitionSize); n++)
+            mFftBuffer[(size_t) (n - start)] = static_cast<float>(kernel[n]);
+        mFft->performRealOnlyForwardTransform(mFftBuffer.data(), true);
+        std::copy_n(mFftBuffer.begin(), spectrumSize, mKernelSpectra.begin() + (std::ptrdiff_t) (spectrumSize * (size_t) partition));
+    }
+}
+
+template <typename SampleType>
+void PartitionedConvolver<SampleType>::process(SampleType* samples, size_t numSamples, int channelIndex) {
+    auto& channel = mChannels[(size_t) channelIndex];
+    float* input = channel.input.data() + mPartitionSize;
+    const float* output = channel.output.data();
+    size_t done = 0;
+    while (done < numSamples) {
+        const size_t count = juce::jmin(numSamples - done, (size_t) (mPartitionSize - channel.fill));
+        for (size_t n = 0; n < count; n++) {
+            input[channel.fill + (int) n] = static_cast<float>(samples[done + n]);
+            samples[done + n] = static_cast<SampleType>(output[channel.fill + (int) n]);
+        }
+        channel.fill += (int) count;
+        done += count;
+        if (channel.fill == mPartitionSize) {
+            processPartition(channel);
+            channel.fill = 0;
+        }
+    }
+}
+
+template <typename SampleType>
+void PartitionedConvolver<SampleType>::processPartition(Channel& channel) {
+    const size_t spectrumSize = 2 * (size_t) mNumBins;
+    const size_t partitionSize = (size_t) mPartitionSize;
+
+    // Spectrum of the last two partitions of input, newest in the delay line
+    std::copy(channel.input.begin(), channel.input.end(), mFftBuffer.begin());
+    std::fill(mFftBuffer.begin() + (std::ptrdiff_t) (2 * partitionSize), mFftBuffer.end(), 0.0f);
+    mFft->performRealOnlyForwardTransform(mFftBuffer.data(), true);
+    channel.position = (channel.position + 1) % mNumPartitions;
+    std::copy_n(mFftBuffer.begin(), spectrumSize, channel.spectra.begin() + (std::ptrdiff_t) (spectrumSize * (size_t) channel.position));
+
+    // Input spectrum k blocks old times kernel partition k
+    std::fill(mAccumulator.begin(), mAccumulator.end(), 0.0f);
+    float* accumulator = mAccumulator.data();
+    for (int partition = 0; partition < mNumPartitions; partition++) {
+        const int slot = (channel.position - partition + mNumPartitions) % mNumPartitions;
+        const float* x = channel.spectra.data() + spectrumSize * (size_t) slot;
+        const float* h = mKernelSpectra.data() + spectrumSize * (size_t) partition;
+        for (size_t bin = 0; bin < spectrumSize; bin += 2) {
+            accumulator[bin] += x[bin] * h[bin] - x[bin + 1] * h[bin + 1];
+            accumulator[bin + 1] += x[bin] * h[bin + 1] + x[bin + 1] * h[bin];
+        }
+    }
+
+    // Overlap-save : the second half of the circular convolution is the linear one
+    std::copy(mAccumulator.begin(), mAccumulator.end(), mFftBuffer.begin());
+    std::fill(mFftBuffer.begin() + (std::ptrdiff_t) spectrumSize, mFftBuffer.end(), 0.0f);
+    mFft->performRealOnlyInverseTransform(mFftBuffer.data());
+    std::copy_n(mFftBuffer.begin() + (std::ptrdiff_t) partitionSize, partitionSize, channel.output.begin());
+
+    // The current partition becomes the previous one
+    std::copy(channel.input.begin() + (std::ptrdiff_t) partitionSize, channel.input.end(), channel.input.begin());
+}
+
+template class PartitionedConvolver<float>;
+template class PartitionedConvolver<double>;
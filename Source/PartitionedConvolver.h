@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+    PartitionedConvolver.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Uniformly partitioned overlap-save convolution with a frequency domain delay line, on juce::dsp::FFT.
+   The kernel is cut into partitions of partitionSize samples, each one transformed once by setKernel().
+   Every partitionSize input samples the last 2 * partitionSize inputs are transformed, pushed in the
+   delay line of spectra and multiplied with the kernel partitions, then one inverse transform gives
+   partitionSize outputs. Cost per sample is about two FFTs of 2 * partitionSize over partitionSize samples
+   plus one complex multiply per kernel sample, latency is partitionSize samples : smaller partitions trade
+   CPU for latency.
+   The transforms, spectra and overlap buffers are float whatever SampleType is : juce::dsp::FFT only comes in
+   float, and this only filters the side chain, where the rounding noise (about -140 dB) stays far below
+   anything the detector reacts to. Double samples are converted on the way in and out.
+   Everything is allocated by prepare(). */
+template <typename SampleType>
+class PartitionedConvolver {
+public:
+    PartitionedConvolver() {};
+    ~PartitionedConvolver() {};
+
+    // Allocates, keep it off the audio thread. partitionSize is rounded up to a power of 2
+    void prepare(int partitionSize, int maxKernelLength, int numChannels);
+    void reset();
+    /* Transforms the kernel into the preallocated partitions, longer kernels are truncated. No allocation,
+       so it can run on the audio thread. The delay line is kept, the new kernel applies from the next partition. */
+    void setKernel(const SampleType* kernel, int length);
+    int getPartitionSize() const { return mPartitionSize; }
+    // The output is delayed by one partition, on top of the delay of the kernel itself
+    int getLatencySamples() const { return mPartitionSize; }
+    // In place. Each channel keeps its own position, any block size
+    void process(SampleType* samples, size_t numSamples, int channel);
+
+private:
+    struct Channel {
+        std::vector<float> input; // last 2 * partitionSize inputs
+        std::vector<float> output; // partitionSize outputs being read
+        std::vector<float> spectra; // delay line, numPartitions spectra of numBins complex values
+        int position = 0; // of the newest spectrum in the delay line
+        int fill = 0; // samples in the current partition
+    };
+    void processPartition(Channel& channel);
+
+    std::unique_ptr<juce::dsp::FFT> mFft;
+    std::vector<float> mKernelSpectra; // numPartitions spectra of numBins complex values, interleaved
+    std::vector<float> mFftBuffer, mAccumulator;
+    std::vector<Channel> mChannels;
+    int mPartitionSize = 0, mNumPartitions = 0, mNumBins = 0;
+};
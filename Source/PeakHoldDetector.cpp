@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+    PeakHoldDetector.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "PeakHoldDetector.h"
+
+template <typename SampleType>
+void PeakHoldDetector<SampleType>::prepare(int maxWindowSamples) {
+    mMaxWindow = juce::jmax(1, maxWindowSamples);
+    mSegment.assign((size_t) mMaxWindow, static_cast<SampleType>(0.0));
+    mSuffix.assign((size_t) mMaxWindow + 1, static_cast<SampleType>(0.0));
+    mWindow = juce::jlimit(1, mMaxWindow, mWindow);
+    reset();
+}
+
+template <typename SampleType>
+void PeakHoldDetector<SampleType>::setWindow(int windowSamples) {
+    windowSamples = juce::jlimit(1, mMaxWindow, windowSamples);
+    if (windowSamples == mWindow)
+        return;
+    mWindow = windowSamples;
+    reset();
+}
+
+template <typename SampleType>
+void PeakHoldDetector<SampleType>::reset() {
+    std::fill(mSuffix.begin(), mSuffix.end(), static_cast<SampleType>(0.0));
+    mPrefix = static_cast<SampleType>(0.0);
+    mPosition = 0;
+}
+
+template <typename SampleType>
+void PeakHoldDetector<SampleType>::process(const SampleType* input, SampleType* levels, size_t numSamples) {
+    SampleType* segment = mSegment.data();
+    const SampleType* suffix = mSuffix.data();
+    size_t n = 0;
+    while (n < numSamples) {
+        // Run up to the end of the current segment or of the block
+        const size_t run = juce::jmin(numSamples - n, (size_t) (mWindow - mPosition));
+        SampleType prefix = mPrefix;
+        for (size_t i = 0; i < run; i++) {
+            const size_t position = (size_t) mPosition + i;
+            const SampleType value = std::abs(input[n + i]);
+            segment[position] = value;
+            prefix = juce::jmax(prefix, value);
+            levels[n + i] = juce::jmax(prefix, suffix[position + 1]);
+        }
+        mPrefix = prefix;
+        mPosition += (int) run;
+        n += run;
+
+        if (mPosition == mWindow) {
+            SampleType max = static_cast<SampleType>(0.0);
+            for (int i = mWindow - 1; i >= 0; i--) {
+                max = juce::jmax(max, segment[i]);
+                mSuffix[(size_t) i] = max;
+            }
+            mSuffix[(size_t) mWindow] = static_cast<SampleType>(0.0);
+            mPrefix = static_cast<SampleType>(0.0);
+            mPosition = 0;
+        }
+    }
+}
+
+template class PeakHoldDetector<float>;
+template class PeakHoldDetector<double>;
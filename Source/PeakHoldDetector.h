@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+    PeakHoldDetector.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Maximum of |input| over the last mWindow samples (current one included), van Herk / Gil-Werman style.
+   Time is cut in segments of mWindow samples : the running max since the start of the current segment
+   is combined with the max from the same position to the end of the previous segment (mSuffix),
+   which is computed once per segment by a backward pass. About three operations per sample
+   whatever the window length, with no data dependent branches. */
+template <typename SampleType>
+class PeakHoldDetector {
+public:
+    PeakHoldDetector() {};
+    ~PeakHoldDetector() {};
+
+    // Allocates, keep it off the audio thread
+    void prepare(int maxWindowSamples);
+    // Clamped to [1, maxWindowSamples], the detector restarts from silence when the window changes
+    void setWindow(int windowSamples);
+    int getWindow() const { return mWindow; }
+    void reset();
+    void process(const SampleType* input, SampleType* levels, size_t numSamples);
+private:
+    std::vector<SampleType> mSegment; // |input| since the start of the current segment
+    std::vector<SampleType> mSuffix;  // mSuffix[i] = max of the previous segment from i to its end, mSuffix[mWindow] = 0
+    SampleType mPrefix = 0.0;
+    int mWindow = 1, mMaxWindow = 1, mPosition = 0;
+};
@@ -1,142 +1,134 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "Comp.h"
-#include "../Utilities/Utils.h"
-
-#define NUM_EQ_BANDS 3
-
-namespace ParameterID
-{
-#define PARAMETER_ID(str) const juce::ParameterID str(#str, 1);
-    PARAMETER_ID(attackValue)
-    PARAMETER_ID(holdValue)
-    PARAMETER_ID(releaseValue)
-    PARAMETER_ID(thresholdValue)
-    PARAMETER_ID(kneeValue)
-    PARAMETER_ID(ratioValue)
-    PARAMETER_ID(makeUpGainValue)
-    PARAMETER_ID(estimationTypeValue)
-    PARAMETER_ID(externalSideChain)
-    PARAMETER_ID(bypassValue)
-    PARAMETER_ID(eqBandFreq1)
-    PARAMETER_ID(eqBandQuality1)
-    PARAMETER_ID(eqBandGain1)
-    PARAMETER_ID(eqBandActive1)
-    PARAMETER_ID(eqBandSlope1)
-    PARAMETER_ID(eqBandType1)
-    PARAMETER_ID(eqBandFreq2)
-    PARAMETER_ID(eqBandQuality2)
-    PARAMETER_ID(eqBandGain2)
-    PARAMETER_ID(eqBandActive2)
-    PARAMETER_ID(eqBandSlope2)
-    PARAMETER_ID(eqBandType2)
-    PARAMETER_ID(eqBandFreq3)
-    PARAMETER_ID(eqBandQuality3)
-    PARAMETER_ID(eqBandGain3)
-    PARAMETER_ID(eqBandActive3)
-    PARAMETER_ID(eqBandSlope3)
-    PARAMETER_ID(eqBandType3)
-}
-
-template <typename T>
-inline static void castParameter(juce::AudioProcessorValueTreeState& apvts, const juce::ParameterID& Id, T& dest) {
-    dest = dynamic_cast<T>(apvts.getParameter(Id.getParamID()));
-    jassert(dest);
-}
-
-//==============================================================================
-/**
-*/
-
-struct compEqBandParams {
-    juce::AudioParameterFloat* freq;
-    juce::AudioParameterFloat* quality;
-    juce::AudioParameterFloat* gain;
-    juce::AudioParameterChoice* slope;
-    juce::AudioParameterChoice* type;
-    juce::AudioParameterBool* active;
-};
-
-struct compEqParams {
-    compEqBandParams bands[NUM_EQ_BANDS];
-};
-
-struct compAudioProcessorParams {
-    juce::AudioParameterFloat* attack;
-    juce::AudioParameterFloat* hold;
-    juce::AudioParameterFloat* release;
-    juce::AudioParameterFloat* threshold;
-    juce::AudioParameterFloat* knee;
-    juce::AudioParameterFloat* ratio;
-    juce::AudioParameterFloat* makeUpGain;
-    juce::AudioParameterChoice* estimationType;
-    juce::AudioParameterBool* externalSideChain;
-    juce::AudioParameterBool* bypass;
-    compEqParams eq;
-};
-
-class Simple_compAudioProcessor  : public juce::AudioProcessor,
-                                   public juce::AudioProcessorValueTreeState::Listener
-                            #if JucePlugin_Enable_ARA
-                             , public juce::AudioProcessorARAExtension
-                            #endif
-{
-public:
-    //==============================================================================
-    Simple_compAudioProcessor();
-    ~Simple_compAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void setExternalSideChain(bool active);
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    juce::AudioProcessorValueTreeState apvts;
-private:
-    Comp<float> comp;
-    compAudioProcessorParams params;
-    juce::AudioBuffer<float> inputBuffer, outputBuffer, inputSideChainBuffer, outputSideChainBuffer;
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
-    bool externalSideChain = false, is_bypass = false;
-    void parameterChanged(const juce::String& parameterID, float newValue) override;
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Simple_compAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Comp.h"
+#include "Parameters.h"
+#include "../Utilities/Utils.h"
+#include "../Utilities/RealtimeGuard.h"
+
+// 7.1.4 is 12 channels, 16 leaves room for 9.1.6
+#define MAX_NUM_CHANNELS 16
+// Rate at which the message thread picks up parameter changes and latency changes
+#define PARAMETER_UPDATE_HZ 60
+
+//==============================================================================
+/**
+*/
+
+class Simple_compAudioProcessor  : public juce::AudioProcessor,
+                                   public juce::AudioProcessorParameter::Listener,
+                                   private juce::Timer
+                            #if JucePlugin_Enable_ARA
+                             , public juce::AudioProcessorARAExtension
+                            #endif
+{
+public:
+    //==============================================================================
+    Simple_compAudioProcessor();
+    ~Simple_compAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    // Comp, its detector and the side chain EQ run natively in 64 bit, no conversion in the host
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    juce::AudioProcessorValueTreeState apvts;
+    // Proportion of the real time budget used by processBlock, e.g. to compare kernel variants
+    double getProcessLoad() const { return loadMeasurer.getLoadAsProportion(); }
+private:
+    Comp<float> comp;
+    Comp<double> doubleComp;
+    // Same order as parameterTable
+    std::array<juce::RangedAudioParameter*, PARAM_COUNT> parameters {};
+    float getFloatParameter(ParameterIndex index) const {
+        jassert(parameterTable[index].kind == PARAM_KIND_FLOAT);
+        return static_cast<juce::AudioParameterFloat*>(parameters[index])->get();
+    }
+    int getChoiceParameter(ParameterIndex index) const {
+        jassert(parameterTable[index].kind == PARAM_KIND_CHOICE);
+        return static_cast<juce::AudioParameterChoice*>(parameters[index])->getIndex();
+    }
+    bool getBoolParameter(ParameterIndex index) const {
+        jassert(parameterTable[index].kind == PARAM_KIND_BOOL);
+        return static_cast<juce::AudioParameterBool*>(parameters[index])->get();
+    }
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+    template <typename SampleType>
+    void prepareComp(Comp<SampleType>& compToPrepare, const juce::dsp::ProcessSpec& spec);
+    template <typename SampleType>
+    void processBlockWithComp(juce::AudioBuffer<SampleType>& buffer, Comp<SampleType>& compToUse);
+    int getCompLatencySamples() const;
+    // Every non structural parameter into the comp, which still has to publish them
+    template <typename SampleType>
+    void applyParameters(Comp<SampleType>& compToUpdate);
+    // Settings of an EQ band from its parameters, the ones it does not expose keep their defaults
+    FilterParams getEqBandParameters(size_t index) const;
+    // Message thread : the linear phase side chain EQ kernel, from the band parameters
+    template <typename SampleType>
+    void designEqKernel(Comp<SampleType>& compToUpdate);
+    /* Only the comp of the precision the host renders in is kept up to date. The host prepares again when it
+       switches precision, prepareToPlay() then brings the other one in line with the parameters. */
+    template <typename Function>
+    void updateActiveComp(Function&& update) {
+        if (isUsingDoublePrecision())
+            update(doubleComp);
+        else
+            update(comp);
+    }
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
+    /* Parameter changes, set by parameterValueChanged() on whichever thread moved the parameter. The message
+       thread picks them up in timerCallback() and is the only producer of the comp settings : oversampling,
+       decimation, link mode and EQ backend re-prepare the comps with the processing suspended, the others
+       are designed and published while the audio thread keeps running. */
+    std::atomic<bool> settingsChange { true }, structuralChange { false };
+    // An EQ band moved : the message thread designs the linear phase kernel again
+    std::atomic<bool> kernelChange { false };
+    // Latency of the active comp as last computed, the message thread reports it to the host
+    std::atomic<int> compLatency { 0 };
+    // Called with the index in parameterTable, on whichever thread moved the parameter
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
+    // Message thread : structural changes, settings, linear phase kernels and latency updates
+    void timerCallback() override;
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Simple_compAudioProcessor)
+};
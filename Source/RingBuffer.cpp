@@ -1,79 +1,118 @@
-#include "RingBuffer.h"
-
-int nextPow2(int x) {
-    return (int) pow(2.0, ceilf( log(x)/log(2.0) ) );
-}
-
-template <typename SampleType>
-RingBuffer<SampleType>::RingBuffer(int sampleRate, SampleType maxDelaySeconds, int numChannels) : mRingBuffer() {
-    int maxDelaySamples = ceil(sampleRate * maxDelaySeconds);
-    mMaxDelaySamples = nextPow2(maxDelaySamples); // for optimization read index with & operation instead of %
-    mDelaySample = 0; mNumChannels = numChannels;
-    mRingBuffer.setSize(numChannels, mMaxDelaySamples);
-    writeIndex = 0, readIndex = 0;
-}
-
-template <typename SampleType>
-RingBuffer<SampleType>::~RingBuffer() {
-}
-
-template <typename SampleType>
-int RingBuffer<SampleType>::setDelay(int delaySeconds) {
-    int delaySample = ceil(mSampleRate * delaySeconds);
-    if (delaySample > mMaxDelaySamples) return -1;
-    mDelaySample = delaySample;
-    return 0;
-}
-
-template <typename SampleType>
-int RingBuffer<SampleType>::writeSample(SampleType sample, int channel) {
-    if (channel > mNumChannels) return -1;
-    mRingBuffer.setSample(channel, writeIndex++, sample);
-    if (writeIndex >= mMaxDelaySamples) writeIndex = 0;
-    return 0;
-}
-
-template <typename SampleType>
-int RingBuffer<SampleType>::writeChannel(juce::AudioBuffer<SampleType>& buffer, int channel) {
-    if (channel > mNumChannels) return -1;
-    if (buffer.getNumSamples() > mMaxDelaySamples) return -1;
-    for (int n = 0; n < buffer.getNumSamples(); n++) {
-        mRingBuffer.setSample(channel, writeIndex, buffer.getSample(channel, n));
-        if (++writeIndex >= mMaxDelaySamples) writeIndex = 0;
-    }
-    return 0;
-}
-
-template <typename SampleType>
-int RingBuffer<SampleType>::writeBuffer(juce::AudioBuffer<SampleType> &buffer) {
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
-    if (mNumChannels > numChannels) return -1;
-    if (mMaxDelaySamples < numSamples) return -1;
-    for (int n = 0; n < numSamples; n++) {
-        for (int channel = 0; n < numChannels; n++) {
-            mRingBuffer.setSample(channel, writeIndex, buffer.getSample(channel, n));
-        }
-        if (++writeIndex >= mMaxDelaySamples) writeIndex = 0;
-    }
-    return 0;
-}
-
-template <typename SampleType>
-int RingBuffer<SampleType>::readBuffer(juce::AudioBuffer<SampleType> &buffer) {
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
-    if (mNumChannels > numChannels) return -1;
-    if (mMaxDelaySamples < numChannels) return -1;
-    readIndex = (writeIndex + mMaxDelaySamples - mDelaySample) & (mMaxDelaySamples - 1);
-    for (int n = 0; n < numSamples; n++) {
-        for (int channel = 0; n < numChannels; n++) {
-            buffer.setSample(channel, n, mRingBuffer.getSample(0, readIndex));
-        }
-        if (++readIndex > mMaxDelaySamples) readIndex = 0;
-    }
-    return 0;
-}
-
-template class RingBuffer<float>;
-template class RingBuffer<double>;
+#include "RingBuffer.h"
+
+template <typename SampleType>
+RingBuffer<SampleType>::RingBuffer(int sampleRate, SampleType maxDelaySeconds, int numChannels, int maxBlockSize) : mRingBuffer() {
+    prepare(sampleRate, (int) ceil(sampleRate * maxDelaySeconds), maxBlockSize, numChannels);
+}
+
+template <typename SampleType>
+RingBuffer<SampleType>::~RingBuffer() {
+}
+
+template <typename SampleType>
+void RingBuffer<SampleType>::prepare(int sampleRate, int maxDelaySamples, int maxBlockSize, int numChannels) {
+    mSampleRate = sampleRate;
+    mMaxDelaySamples = maxDelaySamples;
+    mDelaySamples = juce::jmin(mDelaySamples, mMaxDelaySamples);
+    resize(maxDelaySamples + maxBlockSize, numChannels);
+}
+
+template <typename SampleType>
+void RingBuffer<SampleType>::resize(int numSamples, int numChannels) {
+    mSize = juce::nextPowerOfTwo(juce::jmax(numSamples, 1)); // wrap indices with & instead of %
+    mMask = mSize - 1;
+    mNumChannels = numChannels;
+    mRingBuffer.setSize(numChannels, mSize);
+    reset();
+}
+
+template <typename SampleType>
+void RingBuffer<SampleType>::reset() {
+    mRingBuffer.clear();
+    writeIndex = 0;
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::setDelay(SampleType delaySeconds) {
+    return setDelaySamples((int) ceil(mSampleRate * delaySeconds));
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::setDelaySamples(int delaySamples) {
+    if (delaySamples < 0 || delaySamples > mMaxDelaySamples) return -1;
+    mDelaySamples = delaySamples;
+    return 0;
+}
+
+template <typename SampleType>
+void RingBuffer<SampleType>::copyIn(const SampleType* source, int channel, int start, int numSamples) {
+    const int first = juce::jmin(numSamples, mSize - start);
+    SampleType* destination = mRingBuffer.getWritePointer(channel);
+    juce::FloatVectorOperations::copy(destination + start, source, first);
+    juce::FloatVectorOperations::copy(destination, source + first, numSamples - first);
+}
+
+template <typename SampleType>
+void RingBuffer<SampleType>::copyOut(SampleType* destination, int channel, int start, int numSamples) const {
+    const int first = juce::jmin(numSamples, mSize - start);
+    const SampleType* source = mRingBuffer.getReadPointer(channel);
+    juce::FloatVectorOperations::copy(destination, source + start, first);
+    juce::FloatVectorOperations::copy(destination + first, source, numSamples - first);
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::writeSample(SampleType sample, int channel) {
+    if (channel < 0 || channel >= mNumChannels) return -1;
+    mRingBuffer.setSample(channel, writeIndex, sample);
+    if (channel == mNumChannels - 1) writeIndex = (writeIndex + 1) & mMask;
+    return 0;
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::writeChannel(const SampleType* samples, int numSamples, int channel) {
+    if (channel < 0 || channel >= mNumChannels) return -1;
+    if (numSamples > mSize) return -1;
+    copyIn(samples, channel, writeIndex, numSamples);
+    return 0;
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::writeBlock(const juce::dsp::AudioBlock<const SampleType>& block) {
+    const int numSamples = (int) block.getNumSamples();
+    if ((int) block.getNumChannels() < mNumChannels) return -1;
+    if (numSamples + mMaxDelaySamples > mSize) return -1;
+    for (int channel = 0; channel < mNumChannels; channel++)
+        copyIn(block.getChannelPointer((size_t) channel), channel, writeIndex, numSamples);
+    writeIndex = (writeIndex + numSamples) & mMask;
+    return 0;
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::readBlock(const juce::dsp::AudioBlock<SampleType>& block) const {
+    const int numSamples = (int) block.getNumSamples();
+    if ((int) block.getNumChannels() < mNumChannels) return -1;
+    if (numSamples + mDelaySamples > mSize) return -1;
+    const int readIndex = (writeIndex - numSamples - mDelaySamples) & mMask;
+    for (int channel = 0; channel < mNumChannels; channel++)
+        copyOut(block.getChannelPointer((size_t) channel), channel, readIndex, numSamples);
+    return 0;
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block) {
+    if (writeBlock(block) < 0) return -1;
+    return readBlock(block);
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::writeBuffer(juce::AudioBuffer<SampleType> &buffer) {
+    return writeBlock(juce::dsp::AudioBlock<SampleType>(buffer));
+}
+
+template <typename SampleType>
+int RingBuffer<SampleType>::readBuffer(juce::AudioBuffer<SampleType> &buffer) const {
+    return readBlock(juce::dsp::AudioBlock<SampleType>(buffer));
+}
+
+template class RingBuffer<float>;
+template class RingBuffer<double>;
@@ -1,36 +1,52 @@
-/* ==============================================================================
-    RingBuffer.h
-    Created: 15 Jun 2023 12:45:30pm
-    Author:  Quentin Prost
-  ============================================================================== */
-
-#pragma once
-
-#include "JuceHeader.h"
-
-template<typename SampleType>
-class RingBuffer {
-public:
-    RingBuffer() {};
-    RingBuffer(int sampleRate, SampleType maxDelaySeconds, int numChannels);
-    ~RingBuffer();
-    
-    int setDelay(int delaySeconds);
-    int writeSample(SampleType sample, int channel);
-    // Write block of samples from buffer
-    int writeChannel(juce::AudioBuffer<SampleType>& buffer, int channel);
-    // Read samples from the ring buffer and store it into buffer
-    int writeBuffer(juce::AudioBuffer<SampleType>& buffer);
-    int readBuffer(juce::AudioBuffer<SampleType>& buffer);
-    
-    int getNumChannels();
-    int maxDelaySamples();
-    void resize(int numSamples, int numChannels);
-    void update();
-    void reset();
-private:
-    juce::AudioBuffer<SampleType> mRingBuffer;
-    int mMaxDelaySamples, mDelaySample;
-    int writeIndex, readIndex;
-    int mSampleRate = 44100, mNumChannels = 2;
-};
+/* ==============================================================================
+    RingBuffer.h
+    Created: 15 Jun 2023 12:45:30pm
+    Author:  Quentin Prost
+  ============================================================================== */
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Multichannel delay line. The capacity is a power of two so that indices wrap with a mask,
+   and blocks are moved with at most two contiguous copies per channel (before / after the wrap).
+   A block is written first, then the same number of samples is read mDelaySamples behind it,
+   so the capacity covers the max delay plus the max block size.
+   Functions returning an int give 0 on success and -1 on invalid arguments, like the rest of the class. */
+template<typename SampleType>
+class RingBuffer {
+public:
+    RingBuffer() {};
+    RingBuffer(int sampleRate, SampleType maxDelaySeconds, int numChannels, int maxBlockSize = 0);
+    ~RingBuffer();
+
+    // Allocates, keep it off the audio thread
+    void prepare(int sampleRate, int maxDelaySamples, int maxBlockSize, int numChannels);
+    int setDelay(SampleType delaySeconds);
+    int setDelaySamples(int delaySamples);
+    int getDelaySamples() const { return mDelaySamples; }
+    int writeSample(SampleType sample, int channel);
+    // Write a block of samples of a single channel, the write position only moves with writeBlock / writeSample
+    int writeChannel(const SampleType* samples, int numSamples, int channel);
+    // Write the block at the write position then move it forward
+    int writeBlock(const juce::dsp::AudioBlock<const SampleType>& block);
+    // Read the last block.getNumSamples() written samples, delayed by mDelaySamples
+    int readBlock(const juce::dsp::AudioBlock<SampleType>& block) const;
+    // writeBlock then readBlock, the block ends up delayed by mDelaySamples
+    int process(const juce::dsp::AudioBlock<SampleType>& block);
+    int writeBuffer(juce::AudioBuffer<SampleType>& buffer);
+    int readBuffer(juce::AudioBuffer<SampleType>& buffer) const;
+
+    int getNumChannels() const { return mNumChannels; }
+    int maxDelaySamples() const { return mMaxDelaySamples; }
+    void resize(int numSamples, int numChannels);
+    void reset();
+private:
+    void copyIn(const SampleType* source, int channel, int start, int numSamples);
+    void copyOut(SampleType* destination, int channel, int start, int numSamples) const;
+    juce::AudioBuffer<SampleType> mRingBuffer;
+    int mSize = 0, mMask = 0;
+    int mMaxDelaySamples = 0, mDelaySamples = 0;
+    int writeIndex = 0;
+    int mSampleRate = 44100, mNumChannels = 0;
+};
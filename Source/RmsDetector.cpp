@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+    RmsDetector.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "RmsDetector.h"
+
+template <typename SampleType>
+void RmsDetector<SampleType>::prepare(int maxWindowSamples, int numChannels) {
+    mMaxWindow = juce::jmax(1, maxWindowSamples);
+    mSquares.assign((size_t) numChannels, std::vector<SampleType>((size_t) mMaxWindow));
+    mSums.assign((size_t) numChannels, 0.0);
+    mWindow = juce::jlimit(1, mMaxWindow, mWindow);
+    reset();
+}
+
+template <typename SampleType>
+void RmsDetector<SampleType>::setWindow(int windowSamples) {
+    windowSamples = juce::jlimit(1, mMaxWindow, windowSamples);
+    if (windowSamples == mWindow)
+        return;
+    mWindow = windowSamples;
+    reset();
+}
+
+template <typename SampleType>
+void RmsDetector<SampleType>::reset() {
+    for (auto& squares : mSquares)
+        std::fill(squares.begin(), squares.end(), static_cast<SampleType>(0.0));
+    std::fill(mSums.begin(), mSums.end(), 0.0);
+    mPosition = 0;
+}
+
+template <typename SampleType>
+void RmsDetector<SampleType>::process(const SampleType* const* inputs, SampleType* const* powers, int numChannels, size_t numSamples) {
+    jassert(numChannels <= (int) mSquares.size());
+    const double scale = 1.0 / mWindow;
+    size_t n = 0;
+    while (n < numSamples) {
+        // Run up to the end of the window storage or of the block
+        const size_t run = juce::jmin(numSamples - n, (size_t) (mWindow - mPosition));
+        for (int channel = 0; channel < numChannels; channel++) {
+            const SampleType* input = inputs[channel] + n;
+            SampleType* power = powers[channel] + n;
+            SampleType* squares = mSquares[(size_t) channel].data() + mPosition;
+            double sum = mSums[(size_t) channel];
+            for (size_t i = 0; i < run; i++) {
+                const SampleType square = input[i] * input[i];
+                sum += static_cast<double>(square) - static_cast<double>(squares[i]);
+                squares[i] = square;
+                power[i] = static_cast<SampleType>(sum * scale);
+            }
+            mSums[(size_t) channel] = sum;
+        }
+        mPosition += (int) run;
+        n += run;
+
+        if (mPosition == mWindow) {
+            // Drift correction, the storage now holds exactly the current window
+            for (int channel = 0; channel < numChannels; channel++) {
+                const SampleType* squares = mSquares[(size_t) channel].data();
+                double sum = 0.0;
+                for (int i = 0; i < mWindow; i++)
+                    sum += squares[i];
+                mSums[(size_t) channel] = sum;
+            }
+            mPosition = 0;
+        }
+    }
+}
+
+template class RmsDetector<float>;
+template class RmsDetector<double>;
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+    RmsDetector.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+/* Mean power (mean of x^2) over a rectangular window of mWindow samples, per channel.
+   A running sum of squares is updated with the incoming and outgoing samples, accumulated in double,
+   and recomputed from the stored squares once per window to cancel the rounding drift.
+   The output is the power itself : the gain computer takes 10 * log10 of it, no square root needed
+   (see COMP_LEVEL_POWER). */
+template <typename SampleType>
+class RmsDetector {
+public:
+    RmsDetector() {};
+    ~RmsDetector() {};
+
+    // Allocates, keep it off the audio thread
+    void prepare(int maxWindowSamples, int numChannels);
+    // Clamped to [1, maxWindowSamples], the detector restarts from silence when the window changes
+    void setWindow(int windowSamples);
+    int getWindow() const { return mWindow; }
+    void reset();
+    // Channels share the write position : pass the same channels on every call
+    void process(const SampleType* const* inputs, SampleType* const* powers, int numChannels, size_t numSamples);
+    void process(const SampleType* input, SampleType* power, size_t numSamples) {
+        process(&input, &power, 1, numSamples);
+    }
+private:
+    std::vector<std::vector<SampleType>> mSquares; // last mWindow squares of each channel, written at mPosition
+    std::vector<double> mSums;
+    int mWindow = 1, mMaxWindow = 1, mPosition = 0;
+};
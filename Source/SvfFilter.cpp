@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+    SvfFilter.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#include "SvfFilter.h"
+
+template <typename SampleType>
+SvfCoefficients<SampleType> SvfFilter<SampleType>::computeCoefficients(SvfType type, double freq, double sampleRate, double quality, double gainDb) {
+    const double normalisedFreq = juce::jlimit(0.0, SVF_MAX_NORMALISED_FREQ, freq / sampleRate);
+    SvfCoefficients<SampleType> coefficients;
+    coefficients.type = type;
+    coefficients.tanFreq = static_cast<SampleType>(std::tan(juce::MathConstants<double>::pi * normalisedFreq));
+    coefficients.quality = static_cast<SampleType>(juce::jmax(quality, 0.1));
+    coefficients.amplitude = static_cast<SampleType>(std::pow(10.0, gainDb / 40.0));
+    return coefficients;
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::prepare(double sampleRate, int numChannels) {
+    mTanTable = &SvfTanTable<SampleType>::get();
+    mInverseSampleRate = static_cast<SampleType>(1.0 / sampleRate);
+    mState1.assign((size_t) numChannels, static_cast<SampleType>(0.0));
+    mState2.assign((size_t) numChannels, static_cast<SampleType>(0.0));
+    mMix = computeMix(mCoefficients);
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::reset() {
+    std::fill(mState1.begin(), mState1.end(), static_cast<SampleType>(0.0));
+    std::fill(mState2.begin(), mState2.end(), static_cast<SampleType>(0.0));
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::setCoefficients(const SvfCoefficients<SampleType>& coefficients) {
+    mCoefficients = coefficients;
+    mMix = computeMix(coefficients);
+}
+
+template <typename SampleType>
+template <SvfType Type>
+typename SvfFilter<SampleType>::Mix SvfFilter<SampleType>::computeMix(SampleType tanFreq, SampleType quality, SampleType amplitude) noexcept {
+    const SampleType one = static_cast<SampleType>(1.0);
+    SampleType g = tanFreq, k = one / quality;
+    Mix mix;
+    if constexpr (Type == SVF_LOWPASS) {
+        mix.m0 = 0.0; mix.m1 = 0.0; mix.m2 = one;
+    } else if constexpr (Type == SVF_HIGHPASS) {
+        mix.m0 = one; mix.m1 = -k; mix.m2 = -one;
+    } else if constexpr (Type == SVF_NOTCH) {
+        mix.m0 = one; mix.m1 = -k; mix.m2 = 0.0;
+    } else if constexpr (Type == SVF_PEAK) {
+        k = one / (quality * amplitude);
+        mix.m0 = one; mix.m1 = k * (amplitude * amplitude - one); mix.m2 = 0.0;
+    } else if constexpr (Type == SVF_LOWSHELF) {
+        g = tanFreq / std::sqrt(amplitude);
+        mix.m0 = one; mix.m1 = k * (amplitude - one); mix.m2 = amplitude * amplitude - one;
+    } else {
+        g = tanFreq * std::sqrt(amplitude);
+        mix.m0 = amplitude * amplitude; mix.m1 = k * (one - amplitude) * amplitude; mix.m2 = one - amplitude * amplitude;
+    }
+    mix.a1 = one / (one + g * (g + k));
+    mix.a2 = g * mix.a1;
+    mix.a3 = g * mix.a2;
+    return mix;
+}
+
+template <typename SampleType>
+typename SvfFilter<SampleType>::Mix SvfFilter<SampleType>::computeMix(const SvfCoefficients<SampleType>& coefficients) noexcept {
+    const SampleType tanFreq = coefficients.tanFreq, quality = coefficients.quality, amplitude = coefficients.amplitude;
+    switch (coefficients.type) {
+        case SVF_LOWPASS: return computeMix<SVF_LOWPASS>(tanFreq, quality, amplitude);
+        case SVF_LOWSHELF: return computeMix<SVF_LOWSHELF>(tanFreq, quality, amplitude);
+        case SVF_NOTCH: return computeMix<SVF_NOTCH>(tanFreq, quality, amplitude);
+        case SVF_HIGHPASS: return computeMix<SVF_HIGHPASS>(tanFreq, quality, amplitude);
+        case SVF_HIGHSHELF: return computeMix<SVF_HIGHSHELF>(tanFreq, quality, amplitude);
+        default: return computeMix<SVF_PEAK>(tanFreq, quality, amplitude);
+    }
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::process(SampleType* samples, size_t numSamples, int channel) {
+    const Mix mix = mMix;
+    SampleType s1 = mState1[(size_t) channel], s2 = mState2[(size_t) channel];
+    for (size_t n = 0; n < numSamples; n++) {
+        const SampleType v0 = samples[n];
+        const SampleType v3 = v0 - s2;
+        const SampleType v1 = mix.a1 * s1 + mix.a2 * v3;
+        const SampleType v2 = s2 + mix.a2 * s1 + mix.a3 * v3;
+        s1 = static_cast<SampleType>(2.0) * v1 - s1;
+        s2 = static_cast<SampleType>(2.0) * v2 - s2;
+        samples[n] = mix.m0 * v0 + mix.m1 * v1 + mix.m2 * v2;
+    }
+    mState1[(size_t) channel] = s1;
+    mState2[(size_t) channel] = s2;
+}
+
+template <typename SampleType>
+template <SvfType Type>
+void SvfFilter<SampleType>::processModulated(SampleType* samples, const SampleType* gains, const SampleType* freqs, size_t numSamples, int channel) {
+    const SampleType quality = mCoefficients.quality;
+    const SampleType minGain = static_cast<SampleType>(SVF_MIN_MODULATION_GAIN);
+    SampleType tanFreq = mCoefficients.tanFreq, amplitude = mCoefficients.amplitude;
+    SampleType s1 = mState1[(size_t) channel], s2 = mState2[(size_t) channel];
+    for (size_t n = 0; n < numSamples; n++) {
+        if (freqs != nullptr)
+            tanFreq = (*mTanTable)(freqs[n] * mInverseSampleRate);
+        // The gain is A^2, its square root scales A
+        if (gains != nullptr)
+            amplitude = mCoefficients.amplitude * std::sqrt(juce::jmax(gains[n], minGain));
+        const Mix mix = computeMix<Type>(tanFreq, quality, amplitude);
+        const SampleType v0 = samples[n];
+        const SampleType v3 = v0 - s2;
+        const SampleType v1 = mix.a1 * s1 + mix.a2 * v3;
+        const SampleType v2 = s2 + mix.a2 * s1 + mix.a3 * v3;
+        s1 = static_cast<SampleType>(2.0) * v1 - s1;
+        s2 = static_cast<SampleType>(2.0) * v2 - s2;
+        samples[n] = mix.m0 * v0 + mix.m1 * v1 + mix.m2 * v2;
+    }
+    mState1[(size_t) channel] = s1;
+    mState2[(size_t) channel] = s2;
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::processPeakGain(SampleType* samples, const SampleType* gains, size_t numSamples, int channel) {
+    /* The centre gain is 1 + m1 / k whatever the damping k, so keeping k = 1 / (Q * A) of the set gain and
+       moving m1 = k * (A^2 - 1) alone still gives A^2 there, without a square root or a division. */
+    const Mix mix = mMix;
+    const SampleType one = static_cast<SampleType>(1.0);
+    const SampleType k = one / (mCoefficients.quality * mCoefficients.amplitude);
+    const SampleType squaredAmplitude = mCoefficients.amplitude * mCoefficients.amplitude;
+    const SampleType minGain = static_cast<SampleType>(SVF_MIN_MODULATION_GAIN);
+    SampleType s1 = mState1[(size_t) channel], s2 = mState2[(size_t) channel];
+    for (size_t n = 0; n < numSamples; n++) {
+        const SampleType m1 = k * (squaredAmplitude * juce::jmax(gains[n], minGain) - one);
+        const SampleType v0 = samples[n];
+        const SampleType v3 = v0 - s2;
+        const SampleType v1 = mix.a1 * s1 + mix.a2 * v3;
+        const SampleType v2 = s2 + mix.a2 * s1 + mix.a3 * v3;
+        s1 = static_cast<SampleType>(2.0) * v1 - s1;
+        s2 = static_cast<SampleType>(2.0) * v2 - s2;
+        samples[n] = v0 + m1 * v1;
+    }
+    mState1[(size_t) channel] = s1;
+    mState2[(size_t) channel] = s2;
+}
+
+template <typename SampleType>
+void SvfFilter<SampleType>::processModulated(SampleType* samples, const SampleType* gains, const SampleType* freqs, size_t numSamples, int channel) {
+    jassert(mTanTable != nullptr);
+    const SvfType type = mCoefficients.type;
+    // Cuts and notches have no gain to modulate
+    if (type == SVF_LOWPASS || type == SVF_HIGHPASS || type == SVF_NOTCH)
+        gains = nullptr;
+    if (gains == nullptr && freqs == nullptr) {
+        process(samples, numSamples, channel);
+        return;
+    }
+    if (type == SVF_PEAK && freqs == nullptr) {
+        processPeakGain(samples, gains, numSamples, channel);
+        return;
+    }
+    // One loop per type, the mix is then branch free
+    switch (type) {
+        case SVF_LOWPASS: processModulated<SVF_LOWPASS>(samples, gains, freqs, numSamples, channel); break;
+        case SVF_LOWSHELF: processModulated<SVF_LOWSHELF>(samples, gains, freqs, numSamples, channel); break;
+        case SVF_NOTCH: processModulated<SVF_NOTCH>(samples, gains, freqs, numSamples, channel); break;
+        case SVF_HIGHPASS: processModulated<SVF_HIGHPASS>(samples, gains, freqs, numSamples, channel); break;
+        case SVF_HIGHSHELF: processModulated<SVF_HIGHSHELF>(samples, gains, freqs, numSamples, channel); break;
+        default: processModulated<SVF_PEAK>(samples, gains, freqs, numSamples, channel); break;
+    }
+}
+
+template class SvfFilter<float>;
+template class SvfFilter<double>;
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+    SvfFilter.h
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "JuceHeader.h"
+
+// tan(pi * f / fs) is tabulated up to this normalised frequency, higher ones are clamped to it
+#define SVF_MAX_NORMALISED_FREQ 0.49
+#define SVF_TAN_TABLE_SIZE 4096
+// Lowest modulation gain, -100 dB like the gain computer floor
+#define SVF_MIN_MODULATION_GAIN 1.0e-5
+
+// Same order as FilterType
+enum SvfType {
+    SVF_LOWPASS,
+    SVF_LOWSHELF,
+    SVF_PEAK,
+    SVF_NOTCH,
+    SVF_HIGHPASS,
+    SVF_HIGHSHELF
+};
+
+/* The unmodulated settings of one SvfFilter. Plain values, so they can be computed on the control
+   side and handed to the audio thread by copy. */
+template <typename SampleType>
+struct SvfCoefficients {
+    SvfType type = SVF_PEAK;
+    SampleType tanFreq = 0.0; // tan(pi * freq / sampleRate)
+    SampleType quality = 0.707;
+    SampleType amplitude = 1.0; // square root of the linear band gain (A of the RBJ formulas)
+};
+
+/* tan(pi * x) for x = f / fs in [0, SVF_MAX_NORMALISED_FREQ], linear interpolation between
+   SVF_TAN_TABLE_SIZE + 1 points. Relative error below 4e-5 at 0.49, far less lower down.
+   Shared by every filter, built by the first get() : SvfFilter::prepare() calls it so that it is
+   never built on the audio thread. */
+template <typename SampleType>
+class SvfTanTable {
+public:
+    static const SvfTanTable& get() {
+        static const SvfTanTable table;
+        return table;
+    }
+
+    SampleType operator()(SampleType normalisedFreq) const noexcept {
+        const SampleType position = juce::jlimit(static_cast<SampleType>(0.0), static_cast<SampleType>(SVF_TAN_TABLE_SIZE), normalisedFreq * mScale);
+        const int index = juce::jmin((int) position, SVF_TAN_TABLE_SIZE - 1);
+        const SampleType fraction = position - static_cast<SampleType>(index);
+        return mValues[(size_t) index] + fraction * (mValues[(size_t) index + 1] - mValues[(size_t) index]);
+    }
+
+private:
+    SvfTanTable() {
+        for (size_t index = 0; index < mValues.size(); index++)
+            mValues[index] = static_cast<SampleType>(std::tan(juce::MathConstants<double>::pi * SVF_MAX_NORMALISED_FREQ * (double) index / SVF_TAN_TABLE_SIZE));
+    }
+
+    std::array<SampleType, SVF_TAN_TABLE_SIZE + 1> mValues;
+    const SampleType mScale = static_cast<SampleType>(SVF_TAN_TABLE_SIZE / SVF_MAX_NORMALISED_FREQ);
+};
+
+/* Topology preserving transform (trapezoidal) state variable filter, one state per channel, in the
+   formulation of A. Simper's "linear trap SVF". Unlike a biquad its states stay valid whatever the
+   coefficients do, so the cut off and the gain can move every sample. Cost of processModulated() per sample :
+   - gain only, peak       : one multiply add on top of process(), only the output mix follows the gain
+   - gain only, shelves    : the whole mix, two square roots and a division
+   - gain only, cuts, notch: nothing, the gain does not apply and process() runs
+   - frequency             : one tan lookup plus the whole mix, a division and the shelf square roots
+   Cuts are 12 dB/oct. */
+template <typename SampleType>
+class SvfFilter {
+public:
+    SvfFilter() {};
+    ~SvfFilter() {};
+
+    static SvfCoefficients<SampleType> computeCoefficients(SvfType type, double freq, double sampleRate, double quality, double gainDb);
+
+    // Allocates, keep it off the audio thread
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+    // Copies only, the states are kept
+    void setCoefficients(const SvfCoefficients<SampleType>& coefficients);
+    const SvfCoefficients<SampleType>& getCoefficients() const { return mCoefficients; }
+
+    // In place, with the coefficients as set
+    void process(SampleType* samples, size_t numSamples, int channel);
+    /* In place, modulated per sample. gains multiply the linear band gain (peak and shelves only, e.g. the
+       gain curve of a compressor), freqs replace the cut off, in Hz. Either one can be nullptr. With gains
+       only, a peak keeps the bandwidth of its set gain and reaches the modulated gain at its centre. */
+    void processModulated(SampleType* samples, const SampleType* gains, const SampleType* freqs, size_t numSamples, int channel);
+
+private:
+    // Integrator gains a1 a2 a3 and output mix m0 m1 m2
+    struct Mix {
+        SampleType a1, a2, a3, m0, m1, m2;
+    };
+    template <SvfType Type>
+    static Mix computeMix(SampleType tanFreq, SampleType quality, SampleType amplitude) noexcept;
+    static Mix computeMix(const SvfCoefficients<SampleType>& coefficients) noexcept;
+    template <SvfType Type>
+    void processModulated(SampleType* samples, const SampleType* gains, const SampleType* freqs, size_t numSamples, int channel);
+    // Peak with a gain modulation only : the integrators keep the set mix, only m1 moves
+    void processPeakGain(SampleType* samples, const SampleType* gains, size_t numSamples, int channel);
+
+    SvfCoefficients<SampleType> mCoefficients;
+    Mix mMix {};
+    std::vector<SampleType> mState1, mState2; // per channel
+    const SvfTanTable<SampleType>* mTanTable = nullptr;
+    SampleType mInverseSampleRate = static_cast<SampleType>(1.0 / 44100.0);
+};
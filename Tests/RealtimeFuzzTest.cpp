@@ -0,0 +1,447 @@
+/*
+  ==============================================================================
+    RealtimeFuzzTest.cpp
+    Author:  Quentin Prost
+  ==============================================================================
+*/
+
+/* Headless run of the processor, built with SIMPLE_COMP_REALTIME_GUARD=1 and SIMPLE_COMP_REALTIME_GUARD_ABORT=1
+   by simple_comp_tests.jucer : the first allocation or lock inside processBlock aborts with a backtrace.
+   Each round picks a sample rate, a maximum block size and a precision, prepares the processor like a host
+   would, then an audio thread processes blocks of random sizes while moving random parameters with
+   setValueNotifyingHost(), as host automation does. The main thread runs the message loop meanwhile, so the
+   structural changes are applied under suspendProcessing() while the audio thread is running. Before the
+   rounds, checkEqLatency() checks the latency reported for the linear phase side chain EQ, checkOversizedBlock()
+   that a block longer than prepared still comes out delayed by the reported latency, checkMultiband() runs the
+   MultibandComp, which the processor does not use yet, checkCompBank() compares every lane of a CompBank with
+   a scalar model of the same compressor and checkGainTable() compares the gain computer tables with the exact
+   curve.
+   With --bench as first argument it times the default settings in both precisions instead, then the CompBank
+   for a growing number of compressors. */
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+#include "../Source/MultibandComp.h"
+#include "../Source/CompBank.h"
+
+#define FUZZ_NUM_ROUNDS 24
+#define FUZZ_BLOCKS_PER_ROUND 2000
+// Chance for each block to move parameters before it is processed
+#define FUZZ_PARAMETER_CHANCE 0.1f
+
+// Length of the MultibandComp impulse response, long enough for the 100 Hz crossover to ring out
+#define MULTIBAND_RESPONSE_LENGTH 16384
+
+// CompBank check : 7 compressors leave the last SIMD group partially filled whatever the vector width
+#define COMP_BANK_CHECK_LANES 7
+#define COMP_BANK_CHECK_LENGTH 8192
+// Largest difference allowed between a lane and its scalar model, in dB
+#define COMP_BANK_CHECK_TOLERANCE_DB 1.0e-3
+
+// Level step of the gain table check, in dB
+#define GAIN_TABLE_CHECK_STEP_DB 0.00371
+
+// Benchmark : seconds of audio rendered per precision, at 48 kHz in blocks of 512
+#define BENCH_SECONDS 60
+// CompBank benchmark : seconds of audio rendered per number of compressors
+#define COMP_BANK_BENCH_SECONDS 10
+
+static const double fuzzSampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+static const int fuzzBlockSizes[] = { 32, 64, 256, 512, 1024, 2048 };
+
+// The host side of the audio thread : honours suspendProcessing() through the callback lock like the plugin wrappers
+template <typename SampleType>
+static void processBlocks(Simple_compAudioProcessor& processor, int maxBlockSize, int seed) {
+    juce::Random random(seed);
+    juce::AudioBuffer<SampleType> buffer(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), maxBlockSize);
+    juce::MidiBuffer midi;
+    auto& parameters = processor.getParameters();
+
+    for (int block = 0; block < FUZZ_BLOCKS_PER_ROUND; block++) {
+        if (random.nextFloat() < FUZZ_PARAMETER_CHANCE) {
+            const int numChanges = 1 + random.nextInt(4);
+            for (int change = 0; change < numChanges; change++)
+                parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+        }
+
+        const int numSamples = 1 + random.nextInt(maxBlockSize);
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++) {
+            auto* samples = buffer.getWritePointer(channel);
+            for (int n = 0; n < numSamples; n++)
+                samples[n] = static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f);
+        }
+
+        const juce::ScopedLock lock(processor.getCallbackLock());
+        if (processor.isSuspended())
+            buffer.clear();
+        else
+            processor.processBlock(buffer, midi);
+
+        for (int channel = 0; channel < processor.getTotalNumOutputChannels(); channel++) {
+            const auto* samples = buffer.getReadPointer(channel);
+            for (int n = 0; n < numSamples; n++) {
+                if (!std::isfinite(samples[n])) {
+                    std::cerr << "Non finite output, block " << block << std::endl;
+                    std::abort();
+                }
+            }
+        }
+    }
+}
+
+static void runRound(Simple_compAudioProcessor& processor, juce::Random& random, int round) {
+    const double sampleRate = fuzzSampleRates[random.nextInt((int) std::size(fuzzSampleRates))];
+    const int maxBlockSize = fuzzBlockSizes[random.nextInt((int) std::size(fuzzBlockSizes))];
+    const bool doublePrecision = random.nextBool();
+    std::cout << "Round " << round << " : " << sampleRate << " Hz, " << maxBlockSize << " samples, "
+              << (doublePrecision ? "double" : "float") << std::endl;
+
+    processor.releaseResources();
+    processor.setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+    processor.prepareToPlay(sampleRate, maxBlockSize);
+
+    std::atomic<bool> done { false };
+    const int seed = random.nextInt();
+    std::thread audioThread([&] {
+        if (doublePrecision)
+            processBlocks<double>(processor, maxBlockSize, seed);
+        else
+            processBlocks<float>(processor, maxBlockSize, seed);
+        done = true;
+    });
+    while (!done)
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+    audioThread.join();
+}
+
+template <typename SampleType>
+static double benchmark(Simple_compAudioProcessor& processor) {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    processor.releaseResources();
+    processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::Random random(1);
+    juce::AudioBuffer<SampleType> buffer(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+    juce::MidiBuffer midi;
+    const int numBlocks = (int) (BENCH_SECONDS * sampleRate) / blockSize;
+    double elapsed = 0.0;
+    for (int block = 0; block < numBlocks; block++) {
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++) {
+            auto* samples = buffer.getWritePointer(channel);
+            for (int n = 0; n < blockSize; n++)
+                samples[n] = static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f);
+        }
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        processor.processBlock(buffer, midi);
+        elapsed += juce::Time::getMillisecondCounterHiRes() - start;
+    }
+    // Proportion of the real time budget
+    return elapsed / (1000.0 * BENCH_SECONDS);
+}
+
+static void setParameter(Simple_compAudioProcessor& processor, ParameterIndex index, float value) {
+    auto* parameter = static_cast<juce::RangedAudioParameter*>(processor.getParameters()[index]);
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// The linear phase side chain EQ delays the main path by its partition, through prepareToPlay() and through a change while playing
+static void checkEqLatency(Simple_compAudioProcessor& processor) {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    setParameter(processor, PARAM_DECIMATION, 0.0f);
+    setParameter(processor, PARAM_OVERSAMPLING, 0.0f);
+    setParameter(processor, PARAM_LOOKAHEAD, 0.0f);
+    setParameter(processor, PARAM_EQ_LINEAR_PHASE, 1.0f);
+    setParameter(processor, PARAM_EQ_SIDE_CHAIN, 1.0f);
+    setParameter(processor, PARAM_EQ_PARTITION_SIZE, 0.0f); // 64
+    processor.prepareToPlay(sampleRate, blockSize);
+    const int smallLatency = processor.getLatencySamples();
+
+    setParameter(processor, PARAM_EQ_PARTITION_SIZE, 4.0f); // 1024
+    const double timeout = juce::Time::getMillisecondCounterHiRes() + 2000.0;
+    while (processor.getLatencySamples() == smallLatency && juce::Time::getMillisecondCounterHiRes() < timeout)
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+    const int largeLatency = processor.getLatencySamples();
+
+    setParameter(processor, PARAM_EQ_SIDE_CHAIN, 0.0f);
+    juce::AudioBuffer<float> buffer(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+    buffer.clear();
+    juce::MidiBuffer midi;
+    processor.processBlock(buffer, midi);
+    while (processor.getLatencySamples() == largeLatency && juce::Time::getMillisecondCounterHiRes() < timeout + 2000.0)
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+    const int bypassedLatency = processor.getLatencySamples();
+
+    std::cout << "Side chain EQ latency : " << smallLatency << " samples (64), " << largeLatency << " samples (1024), "
+              << bypassedLatency << " samples (off)" << std::endl;
+    if (largeLatency - smallLatency != 1024 - 64 || bypassedLatency != 0) {
+        std::cerr << "Wrong side chain EQ latency" << std::endl;
+        std::abort();
+    }
+    processor.releaseResources();
+}
+
+// Comp splits a block longer than prepared : bypassed, an impulse still comes out delayed by exactly the reported latency
+static void checkOversizedBlock(Simple_compAudioProcessor& processor) {
+    const double sampleRate = 48000.0;
+    const int blockSize = 256, oversizedBlockSize = 16 * blockSize;
+    processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    setParameter(processor, PARAM_DECIMATION, 0.0f);
+    setParameter(processor, PARAM_OVERSAMPLING, 0.0f);
+    setParameter(processor, PARAM_EQ_SIDE_CHAIN, 0.0f);
+    setParameter(processor, PARAM_LOOKAHEAD, 0.005f);
+    setParameter(processor, PARAM_BYPASS, 1.0f);
+    processor.prepareToPlay(sampleRate, blockSize);
+    const int latency = processor.getLatencySamples();
+
+    juce::AudioBuffer<float> buffer(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), oversizedBlockSize);
+    buffer.clear();
+    buffer.setSample(0, 0, 1.0f);
+    juce::MidiBuffer midi;
+    processor.processBlock(buffer, midi);
+
+    int impulse = -1, numNonZero = 0;
+    for (int n = 0; n < oversizedBlockSize; n++) {
+        if (buffer.getSample(0, n) != 0.0f) {
+            impulse = impulse < 0 ? n : impulse;
+            numNonZero++;
+        }
+    }
+    std::cout << "Oversized block : impulse at " << impulse << " samples, latency " << latency << " samples" << std::endl;
+    if (latency == 0 || impulse != latency || numNonZero != 1 || buffer.getSample(0, impulse) != 1.0f) {
+        std::cerr << "Oversized block not delayed by the reported latency" << std::endl;
+        std::abort();
+    }
+    setParameter(processor, PARAM_BYPASS, 0.0f);
+    processor.releaseResources();
+}
+
+/* Bands that never compress sum back to an allpass : the impulse response keeps the energy of the impulse.
+   Also checks that a crossover cannot cross its neighbours, and runs the processing under the guard. */
+static void checkMultiband() {
+    const int blockSize = 512;
+    MultibandComp<double> multiband;
+    for (int band = 0; band < MULTIBAND_MAX_BANDS; band++)
+        multiband.setBandParams(band, {0.01, 0.0, 0.1, 40.0, 1.0, 0.0, 0.0, EstimationType::peak});
+    multiband.setNumBands(4);
+    multiband.setCrossover(1, 50.0);
+    const bool ordered = multiband.getCrossover(1) == multiband.getCrossover(0);
+    multiband.setCrossover(1, 300.0);
+    multiband.prepare({ 48000.0, (juce::uint32) blockSize, 2 });
+
+    juce::AudioBuffer<double> input(2, MULTIBAND_RESPONSE_LENGTH), output(2, MULTIBAND_RESPONSE_LENGTH);
+    input.clear();
+    input.setSample(0, 0, 1.0);
+    {
+        RealtimeGuard::ScopedAudioThread audioThread;
+        for (int start = 0; start < MULTIBAND_RESPONSE_LENGTH; start += blockSize) {
+            juce::dsp::AudioBlock<const double> inputBlock = juce::dsp::AudioBlock<double>(input).getSubBlock((size_t) start, (size_t) blockSize);
+            juce::dsp::AudioBlock<double> outputBlock = juce::dsp::AudioBlock<double>(output).getSubBlock((size_t) start, (size_t) blockSize);
+            juce::dsp::ProcessContextNonReplacing<double> context(inputBlock, outputBlock);
+            multiband.processBlock(context);
+        }
+    }
+
+    double energy = 0.0;
+    for (int n = 0; n < MULTIBAND_RESPONSE_LENGTH; n++)
+        energy += output.getSample(0, n) * output.getSample(0, n);
+    std::cout << "Multiband impulse response energy : " << energy << std::endl;
+    if (!ordered || std::abs(energy - 1.0) > 1.0e-3) {
+        std::cerr << "Multiband bands do not sum back flat" << std::endl;
+        std::abort();
+    }
+}
+
+/* Scalar model of one CompBank lane, from the classes Comp is built on : juce::dsp::BallisticsFilter with the
+   detector times documented in CompBank.h, then CompAhr in the log domain. */
+template <typename SampleType>
+static void processCompBankLaneModel(const CompParams<SampleType>& params, double sampleRate, const SampleType* input, SampleType* gains, int numSamples) {
+    const bool rms = params.estimationType == EstimationType::RMS;
+    juce::dsp::BallisticsFilter<SampleType> detector;
+    detector.setLevelCalculationType(rms ? juce::dsp::BallisticsFilterLevelCalculationType::RMS : juce::dsp::BallisticsFilterLevelCalculationType::peak);
+    detector.setAttackTime(static_cast<SampleType>(rms ? 300.0 : 0.001));
+    detector.setReleaseTime(static_cast<SampleType>(rms ? 300.0 : 0.01));
+    detector.prepare({ sampleRate, (juce::uint32) numSamples, 1 });
+
+    CompAhr<SampleType> ahr((int) sampleRate, numSamples);
+    ahr.setDomain(COMP_DOMAIN_LOG);
+    const CompAhrParams<SampleType> ahrParams = {params.attack, params.hold, params.release, params.threshold, params.knee, params.ratio, params.makeUpGain};
+    ahr.setCoefficients(CompAhr<SampleType>::computeCoefficients(ahrParams, sampleRate));
+    for (int n = 0; n < numSamples; n++)
+        gains[n] = ahr.processSample(detector.processSample(0, input[n]));
+}
+
+/* Every lane of a CompBank, with its own parameters, follows the scalar model. Bursts alternate with near
+   silence so that attack, hold and release all run, and the calls do not line up with the prepared block size. */
+template <typename SampleType>
+static double getCompBankError() {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512, callSize = 700;
+    CompBank<SampleType> bank;
+    bank.prepare(sampleRate, blockSize, COMP_BANK_CHECK_LANES);
+
+    juce::AudioBuffer<SampleType> input(COMP_BANK_CHECK_LANES, COMP_BANK_CHECK_LENGTH), gains(COMP_BANK_CHECK_LANES, COMP_BANK_CHECK_LENGTH),
+                                  modelGains(COMP_BANK_CHECK_LANES, COMP_BANK_CHECK_LENGTH);
+    for (int lane = 0; lane < COMP_BANK_CHECK_LANES; lane++) {
+        const EstimationType estimationTypes[] = { EstimationType::peak, EstimationType::RMS, EstimationType::peakHold };
+        const SampleType attack = static_cast<SampleType>(0.0005 * (lane + 1)), hold = static_cast<SampleType>(0.004 * (lane % 3));
+        const SampleType release = static_cast<SampleType>(0.02 + 0.03 * lane), threshold = static_cast<SampleType>(-30.0 + 3.0 * lane);
+        const SampleType ratio = static_cast<SampleType>(1.5 + lane), knee = static_cast<SampleType>(lane % 2 == 0 ? 0.0 : 2.0 * lane);
+        bank.setParams(lane, {attack, hold, release, threshold, ratio, knee, static_cast<SampleType>(lane - 3), estimationTypes[lane % 3]});
+
+        auto* samples = input.getWritePointer(lane);
+        for (int n = 0; n < COMP_BANK_CHECK_LENGTH; n++) {
+            const double level = (n / (500 + 100 * lane)) % 2 == 0 ? 0.9 : 0.02;
+            samples[n] = static_cast<SampleType>(level * std::sin(0.01 * (lane + 1) * n));
+        }
+        processCompBankLaneModel(bank.getParams(lane), sampleRate, samples, modelGains.getWritePointer(lane), COMP_BANK_CHECK_LENGTH);
+    }
+
+    {
+        RealtimeGuard::ScopedAudioThread audioThread;
+        for (int start = 0; start < COMP_BANK_CHECK_LENGTH; start += callSize) {
+            const int numSamples = juce::jmin(callSize, COMP_BANK_CHECK_LENGTH - start);
+            const SampleType* sideChains[COMP_BANK_CHECK_LANES];
+            SampleType* laneGains[COMP_BANK_CHECK_LANES];
+            for (int lane = 0; lane < COMP_BANK_CHECK_LANES; lane++) {
+                sideChains[lane] = input.getReadPointer(lane, start);
+                laneGains[lane] = gains.getWritePointer(lane, start);
+            }
+            bank.processSideChain(sideChains, laneGains, COMP_BANK_CHECK_LANES, (size_t) numSamples);
+        }
+    }
+
+    double worst = 0.0;
+    for (int lane = 0; lane < COMP_BANK_CHECK_LANES; lane++)
+        for (int n = 0; n < COMP_BANK_CHECK_LENGTH; n++)
+            worst = juce::jmax(worst, std::abs(20.0 * std::log10((double) gains.getSample(lane, n) / (double) modelGains.getSample(lane, n))));
+    return worst;
+}
+
+static void checkCompBank() {
+    const double floatError = getCompBankError<float>();
+    const double doubleError = getCompBankError<double>();
+    std::cout << "CompBank against its scalar model : " << floatError << " dB float, " << doubleError << " dB double" << std::endl;
+    if (floatError > COMP_BANK_CHECK_TOLERANCE_DB || doubleError > COMP_BANK_CHECK_TOLERANCE_DB) {
+        std::cerr << "CompBank lanes differ from the scalar compressor" << std::endl;
+        std::abort();
+    }
+}
+
+// CompBank cost per compressor and sample : a lone compressor pays for a whole SIMD group, full groups share it
+template <typename SampleType>
+static void benchCompBank() {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    const int laneCount = (int) CompBank<SampleType>::laneCount;
+    const int numBlocks = (int) (COMP_BANK_BENCH_SECONDS * sampleRate) / blockSize;
+
+    juce::Random random(1);
+    juce::AudioBuffer<SampleType> input(16 * laneCount, blockSize), gains(16 * laneCount, blockSize);
+    for (int channel = 0; channel < input.getNumChannels(); channel++)
+        for (int n = 0; n < blockSize; n++)
+            input.setSample(channel, n, static_cast<SampleType>(random.nextFloat() * 2.0f - 1.0f));
+
+    std::cout << "CompBank, " << (std::is_same<SampleType, double>::value ? "double" : "float") << ", " << laneCount << " lanes per SIMD group" << std::endl;
+    double singleCost = 0.0;
+    for (const int numCompressors : { 1, laneCount, 2 * laneCount, 4 * laneCount, 16 * laneCount }) {
+        CompBank<SampleType> bank;
+        bank.prepare(sampleRate, blockSize, numCompressors);
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        for (int block = 0; block < numBlocks; block++)
+            bank.processSideChain(input.getArrayOfReadPointers(), gains.getArrayOfWritePointers(), numCompressors, (size_t) blockSize);
+        const double elapsed = juce::Time::getMillisecondCounterHiRes() - start;
+        // In ns per compressor and sample
+        const double cost = elapsed * 1.0e6 / ((double) numBlocks * blockSize * numCompressors);
+        singleCost = numCompressors == 1 ? cost : singleCost;
+        std::cout << "  " << numCompressors << " compressors : " << cost << " ns per sample and compressor, "
+                  << singleCost / cost << " x the throughput of one" << std::endl;
+    }
+}
+
+// Worst case errors documented in GainComputer.h at 20:1 : at a hard knee corner, inside a 6 dB soft knee
+static const struct { CompGainTableSize size; double hardKneeDb, softKneeDb; } gainTableBounds[] = {
+    { COMP_GAIN_TABLE_256, 0.13, 5.0e-2 },
+    { COMP_GAIN_TABLE_1024, 0.033, 1.2e-2 },
+    { COMP_GAIN_TABLE_4096, 8.0e-3, 3.0e-3 }
+};
+
+// Largest error of the table in dB over the whole table range, against the curve computed with std::cos
+template <typename SampleType>
+static double getGainTableError(CompGainTableSize size, double knee) {
+    using Table = GainComputerTable<SampleType>;
+    const double threshold = -20.0, ratio = 20.0;
+    const CompAhrParams<SampleType> params = {0.01, 0.0, 0.1, threshold, (SampleType) knee, ratio, 0.0, size};
+    const auto coefficients = CompAhr<SampleType>::computeCoefficients(params, 48000.0);
+    Table table;
+    buildGainTable(table, coefficients.curve, coefficients.knee.type == COMP_SOFT_KNEE, (int) coefficients.tableSize);
+
+    const double slope = 1.0 / ratio - 1.0, halfWidth = 0.5 * knee;
+    const double step = (Table::maxLevelDb - Table::minLevelDb) / (double) size;
+    double worst = 0.0;
+    for (double levelDb = Table::minLevelDb; levelDb <= Table::maxLevelDb; levelDb += GAIN_TABLE_CHECK_STEP_DB) {
+        const double overshoot = levelDb - threshold;
+        // The soft knee curve steps at its top, see GainComputer.h
+        if (knee > 0.0 && std::abs(overshoot - halfWidth) < step)
+            continue;
+        double exactDb = overshoot > halfWidth ? slope * overshoot : 0.0;
+        if (knee > 0.0 && std::abs(overshoot) <= halfWidth)
+            exactDb = slope * (overshoot + halfWidth * (1.0 - std::cos(overshoot * juce::MathConstants<double>::pi / knee)));
+        const double gain = (double) gainFromTable(static_cast<SampleType>(std::pow(10.0, levelDb / 20.0)), table);
+        worst = juce::jmax(worst, std::abs(20.0 * std::log10(gain) - exactDb));
+    }
+    return worst;
+}
+
+static void checkGainTable() {
+    bool withinBounds = true;
+    for (const auto& bound : gainTableBounds) {
+        const double hardKnee = juce::jmax(getGainTableError<float>(bound.size, 0.0), getGainTableError<double>(bound.size, 0.0));
+        const double softKnee = juce::jmax(getGainTableError<float>(bound.size, 6.0), getGainTableError<double>(bound.size, 6.0));
+        std::cout << "Gain table " << (int) bound.size << " points : " << hardKnee << " dB hard knee, " << softKnee << " dB soft knee" << std::endl;
+        withinBounds = withinBounds && hardKnee <= bound.hardKneeDb && softKnee <= bound.softKneeDb;
+    }
+    if (!withinBounds) {
+        std::cerr << "Gain table beyond its documented error" << std::endl;
+        std::abort();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    if (argc > 1 && juce::String(argv[1]) == "--bench") {
+        Simple_compAudioProcessor processor;
+        const double floatLoad = benchmark<float>(processor);
+        const double doubleLoad = benchmark<double>(processor);
+        std::cout << "Default settings, stereo, 48 kHz, 512 samples" << std::endl
+                  << "float  : " << floatLoad * 100.0 << " % of real time" << std::endl
+                  << "double : " << doubleLoad * 100.0 << " % of real time" << std::endl;
+        processor.releaseResources();
+        benchCompBank<float>();
+        benchCompBank<double>();
+        return 0;
+    }
+    const juce::int64 seed = argc > 1 ? juce::String(argv[1]).getLargeIntValue() : juce::Time::currentTimeMillis();
+    std::cout << "Seed " << seed << std::endl;
+    juce::Random random(seed);
+
+    Simple_compAudioProcessor processor;
+    checkEqLatency(processor);
+    checkOversizedBlock(processor);
+    checkMultiband();
+    checkCompBank();
+    checkGainTable();
+    for (int round = 0; round < FUZZ_NUM_ROUNDS; round++)
+        runRound(processor, random, round);
+    processor.releaseResources();
+    std::cout << "No real time violation" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+    RealtimeGuard.cpp
+    Author:  Quentin Prost
+*/
+
+#include "RealtimeGuard.h"
+
+#if SIMPLE_COMP_REALTIME_GUARD
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ // glibc entry points, the hooks below forward to them
+ extern "C" void* __libc_malloc(size_t size);
+ extern "C" void* __libc_calloc(size_t count, size_t size);
+ extern "C" void* __libc_realloc(void* pointer, size_t size);
+ extern "C" void __libc_free(void* pointer);
+ extern "C" void* __libc_memalign(size_t alignment, size_t size);
+ // Initial exec TLS never allocates on first access, which the malloc hook would re-enter
+ #define REALTIME_GUARD_TLS __attribute__((tls_model("initial-exec")))
+#else
+ #define REALTIME_GUARD_TLS
+#endif
+
+namespace RealtimeGuard {
+    int& getAudioThreadDepth() noexcept {
+        static thread_local int depth REALTIME_GUARD_TLS = 0;
+        return depth;
+    }
+
+    void reportViolation(const char* what) noexcept {
+        // Building the report allocates
+        ScopedAllow allow;
+        juce::Logger::outputDebugString(juce::String("Real time violation : ") + what + " on the audio thread\n"
+                                        + juce::SystemStats::getStackBacktrace());
+       #if SIMPLE_COMP_REALTIME_GUARD_ABORT
+        std::abort();
+       #else
+        jassertfalse;
+       #endif
+    }
+}
+
+static inline void checkRealtime(const char* what) noexcept {
+    if (RealtimeGuard::getAudioThreadDepth() > 0)
+        RealtimeGuard::reportViolation(what);
+}
+
+// Unchecked allocation, so that operator new is not reported a second time as malloc
+static inline void* rawMalloc(std::size_t size) noexcept {
+   #if JUCE_LINUX
+    return __libc_malloc(size);
+   #else
+    return std::malloc(size);
+   #endif
+}
+
+static inline void rawFree(void* pointer) noexcept {
+   #if JUCE_LINUX
+    __libc_free(pointer);
+   #else
+    std::free(pointer);
+   #endif
+}
+
+static inline void* rawAlignedMalloc(std::size_t size, std::size_t alignment) noexcept {
+   #if JUCE_LINUX
+    return __libc_memalign(alignment, size);
+   #elif JUCE_WINDOWS
+    return _aligned_malloc(size, alignment);
+   #else
+    void* pointer = nullptr;
+    return posix_memalign(&pointer, juce::jmax(alignment, sizeof(void*)), size) == 0 ? pointer : nullptr;
+   #endif
+}
+
+static inline void rawAlignedFree(void* pointer) noexcept {
+   #if JUCE_WINDOWS
+    _aligned_free(pointer);
+   #else
+    rawFree(pointer);
+   #endif
+}
+
+// The array, sized and nothrow forms default to these two, and to the aligned ones below
+void* operator new(std::size_t size) {
+    checkRealtime("operator new");
+    if (void* pointer = rawMalloc(size == 0 ? 1 : size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer != nullptr)
+        checkRealtime("operator delete");
+    rawFree(pointer);
+}
+
+// Over aligned types, e.g. SIMD registers or juce::dsp::SIMDRegister members
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    checkRealtime("aligned operator new");
+    if (void* pointer = rawAlignedMalloc(size == 0 ? 1 : size, static_cast<std::size_t>(alignment)))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    if (pointer != nullptr)
+        checkRealtime("aligned operator delete");
+    rawAlignedFree(pointer);
+}
+
+#if JUCE_LINUX
+extern "C" {
+    void* malloc(size_t size) {
+        checkRealtime("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        checkRealtime("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) {
+        checkRealtime("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) {
+        if (pointer != nullptr)
+            checkRealtime("free");
+        __libc_free(pointer);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size) {
+        checkRealtime("posix_memalign");
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        void* result = __libc_memalign(alignment, size);
+        if (result == nullptr)
+            return ENOMEM;
+        *pointer = result;
+        return 0;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        checkRealtime("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        checkRealtime("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) {
+        using Lock = int (*)(pthread_mutex_t*);
+        static Lock nextLock = reinterpret_cast<Lock>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        checkRealtime("pthread_mutex_lock");
+        return nextLock(mutex);
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+/*
+    RealtimeGuard.h
+    Author:  Quentin Prost
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/* Debug harness for real time safety. Built with SIMPLE_COMP_REALTIME_GUARD=1, any call to operator new /
+   delete (aligned forms included) made while a ScopedAudioThread is alive on the calling thread is reported
+   with a stack trace, then asserts, or aborts with SIMPLE_COMP_REALTIME_GUARD_ABORT=1 so that a run under a
+   debugger or a host stops on the first one. On Linux malloc / calloc / realloc / free, posix_memalign /
+   aligned_alloc / memalign and pthread_mutex_lock are caught too. The hooks are in RealtimeGuard.cpp, the
+   Tests project builds them into a fuzz run of the processor. Off by default, the scopes are then empty objects. */
+#ifndef SIMPLE_COMP_REALTIME_GUARD
+#define SIMPLE_COMP_REALTIME_GUARD 0
+#endif
+
+#ifndef SIMPLE_COMP_REALTIME_GUARD_ABORT
+#define SIMPLE_COMP_REALTIME_GUARD_ABORT 0
+#endif
+
+namespace RealtimeGuard {
+#if SIMPLE_COMP_REALTIME_GUARD
+    // Scopes open on the calling thread, the hooks only report above 0
+    int& getAudioThreadDepth() noexcept;
+    void reportViolation(const char* what) noexcept;
+
+    struct ScopedAudioThread {
+        ScopedAudioThread() noexcept { ++getAudioThreadDepth(); }
+        ~ScopedAudioThread() noexcept { --getAudioThreadDepth(); }
+    };
+
+    // Lifts the guard for a section known not to be real time safe, e.g. the report itself
+    struct ScopedAllow {
+        ScopedAllow() noexcept : depth(getAudioThreadDepth()) { getAudioThreadDepth() = 0; }
+        ~ScopedAllow() noexcept { getAudioThreadDepth() = depth; }
+        const int depth;
+    };
+#else
+    struct ScopedAudioThread {
+        ScopedAudioThread() noexcept {}
+    };
+
+    struct ScopedAllow {
+        ScopedAllow() noexcept {}
+    };
+#endif
+}
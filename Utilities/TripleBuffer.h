@@ -0,0 +1,57 @@
+/*
+    TripleBuffer.h
+    Author:  Quentin Prost
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/* Lock-free handoff of the latest value from one writer thread to one reader thread.
+   The writer fills getWriteBuffer() then calls publish(), the reader calls acquire() (typically
+   once per block) and keeps using getReadBuffer() until its next acquire().
+   Nothing is allocated or locked after construction, intermediate values may be skipped. */
+template <typename Type>
+class TripleBuffer {
+public:
+    TripleBuffer() {};
+    ~TripleBuffer() {};
+
+    // Not thread safe, only to be used before the buffer is shared (e.g. to preallocate storage)
+    void fill(const Type& value) {
+        for (auto& buffer : mBuffers)
+            buffer = value;
+    }
+
+    Type& getWriteBuffer() noexcept {
+        return mBuffers[mWriteIndex];
+    }
+
+    void publish() noexcept {
+        mWriteIndex = mPending.exchange(mWriteIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Returns true when a new value has been published since the previous call
+    bool acquire() noexcept {
+        if ((mPending.load(std::memory_order_relaxed) & newDataFlag) == 0)
+            return false;
+        mReadIndex = mPending.exchange(mReadIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    Type& getReadBuffer() noexcept {
+        return mBuffers[mReadIndex];
+    }
+
+    const Type& getReadBuffer() const noexcept {
+        return mBuffers[mReadIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+    std::array<Type, 3> mBuffers;
+    int mWriteIndex = 0, mReadIndex = 1;
+    std::atomic<int> mPending { 2 };
+};